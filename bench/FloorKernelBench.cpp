@@ -0,0 +1,103 @@
+// Compares the SIMD floor rows against the scalar reference, and checks that
+// the textured row picks the same tile as the flat one on every pixel. The
+// camera sweeps past the map edge so rows cross negative coordinates.
+// Usage: FloorKernelBench [frames]
+#include "engine/FloorKernel.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace PixelsEngine;
+
+namespace {
+
+const int SCREEN_WIDTH = 1280;
+const int SCREEN_HEIGHT = 720;
+
+// Walls, jump pads and abyss cells in a fixed pattern
+void FillMap(Map &map) {
+  for (int y = 0; y < Map::HEIGHT; y++) {
+    for (int x = 0; x < Map::WIDTH; x++) {
+      unsigned v = (x * 73856093u) ^ (y * 19349663u);
+      v ^= v >> 13;
+      const int tiles[] = {0, 0, 0, 1, 3, 4};
+      map.Set(x, y, tiles[v % 6]);
+    }
+  }
+  // Out of bounds reads tile 1; give it a pad bit so border lanes show up
+  map.SetTileFlags(1, TILE_BLOCKS_RAY | TILE_JUMP_PAD);
+}
+
+// The floor rows of one frame, from a camera at (posX, posY) facing `yaw`
+void BuildRows(std::vector<FloorRow> &rows, float posX, float posY,
+               float yaw) {
+  float dirX = std::cos(yaw), dirY = std::sin(yaw);
+  float planeX = -dirY * 0.66f, planeY = dirX * 0.66f;
+  for (int y = 0; y < (int)rows.size(); y++) {
+    float rowDist = 0.5f * SCREEN_HEIGHT / (float)(y + 1);
+    FloorRow &row = rows[y];
+    row.floorX = posX + rowDist * (dirX - planeX);
+    row.floorY = posY + rowDist * (dirY - planeY);
+    row.stepX = rowDist * 2.0f * planeX / SCREEN_WIDTH;
+    row.stepY = rowDist * 2.0f * planeY / SCREEN_WIDTH;
+    row.deepX = row.floorX * 1.5f - posX * 0.5f;
+    row.deepY = row.floorY * 1.5f - posY * 0.5f;
+    row.deepStepX = row.stepX * 1.5f;
+    row.deepStepY = row.stepY * 1.5f;
+    row.shade = 0.4f + 0.8f * (float)y / rows.size();
+  }
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int frames = argc > 1 ? std::atoi(argv[1]) : 200;
+
+  Map map;
+  FillMap(map);
+  // No textures, so the textured row draws the flat colours of its tiles
+  std::vector<const Uint32 *> noTextures(256, nullptr);
+  TexturedFloorKernel textured = SelectTexturedFloorKernel(true, false);
+
+  std::vector<FloorRow> rows(SCREEN_HEIGHT / 2);
+  std::vector<Uint32> scalar(SCREEN_WIDTH), simd(SCREEN_WIDTH),
+      tiled(SCREEN_WIDTH);
+  double ms[3] = {};
+  long long mismatches[2] = {};
+
+  std::printf("%d frames of %d rows at %d pixels\n", frames, (int)rows.size(),
+              SCREEN_WIDTH);
+  for (int f = 0; f < frames; f++) {
+    // Circle a point near the map corner so half the rows leave the map
+    float t = f * 0.05f;
+    BuildRows(rows, 2.0f + 4.0f * std::cos(t * 0.7f),
+              2.0f + 4.0f * std::sin(t * 0.5f), t * 1.3f);
+    for (const FloorRow &row : rows) {
+      auto t0 = std::chrono::steady_clock::now();
+      CastFloorRowScalar(row, map, scalar.data(), SCREEN_WIDTH);
+      auto t1 = std::chrono::steady_clock::now();
+      CastFloorRow(row, map, simd.data(), SCREEN_WIDTH);
+      auto t2 = std::chrono::steady_clock::now();
+      textured(row, map, noTextures.data(), tiled.data(), SCREEN_WIDTH);
+      auto t3 = std::chrono::steady_clock::now();
+      ms[0] += std::chrono::duration<double, std::milli>(t1 - t0).count();
+      ms[1] += std::chrono::duration<double, std::milli>(t2 - t1).count();
+      ms[2] += std::chrono::duration<double, std::milli>(t3 - t2).count();
+
+      for (int x = 0; x < SCREEN_WIDTH; x++) {
+        mismatches[0] += simd[x] != scalar[x];
+        mismatches[1] += tiled[x] != scalar[x];
+      }
+    }
+  }
+  std::printf("scalar %7.3f ms/frame, %-6s %7.3f ms/frame (%.2fx), "
+              "textured %7.3f ms/frame\n",
+              ms[0] / frames, GetFloorKernelName(), ms[1] / frames,
+              ms[0] / ms[1], ms[2] / frames);
+  std::printf("%lld mismatched SIMD pixels, %lld mismatched textured "
+              "pixels\n",
+              mismatches[0], mismatches[1]);
+  return mismatches[0] == 0 && mismatches[1] == 0 ? 0 : 1;
+}
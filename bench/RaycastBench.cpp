@@ -0,0 +1,130 @@
+// Compares scalar, packet and distance-field DDA over every floor cell of
+// a map.
+// Usage: RaycastBench [map file] [frames]
+#include "engine/RayTrace.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace PixelsEngine;
+
+namespace {
+
+const int SCREEN_WIDTH = 1280;
+
+struct View {
+  double x, y, yaw;
+};
+
+double Checksum(const std::vector<RayHit> &hits) {
+  double sum = 0.0;
+  for (const RayHit &h : hits)
+    sum += h.dist + h.side + h.mapX * 31 + h.mapY * 17;
+  return sum;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  const char *path = argc > 1 ? argv[1] : "assets/level1.map";
+  int frames = argc > 2 ? std::atoi(argv[2]) : 200;
+
+  Map map;
+  if (!map.LoadFromFile(path)) {
+    std::fprintf(stderr, "Failed to load map %s\n", path);
+    return 1;
+  }
+  RayTracer tracer;
+  tracer.Build(map);
+
+  // A handful of viewpoints per open cell, spread over all directions
+  std::vector<View> views;
+  for (int y = 0; y < Map::HEIGHT; y++) {
+    for (int x = 0; x < Map::WIDTH; x++) {
+      if (tracer.IsSolid(x, y))
+        continue;
+      for (int k = 0; k < 4; k++)
+        views.push_back({x + 0.3 + 0.1 * k, y + 0.7 - 0.1 * k,
+                         (x * 7 + y * 13 + k * 29) * 0.1});
+    }
+  }
+  if (views.empty()) {
+    std::fprintf(stderr, "Map has no open cells\n");
+    return 1;
+  }
+
+  enum { SCALAR, PACKET, SKIPPING, MODE_COUNT };
+  const char *names[MODE_COUNT] = {"scalar", RayTracer::GetKernelName(),
+                                   "distance field"};
+  std::vector<double> dirX(SCREEN_WIDTH), dirY(SCREEN_WIDTH);
+  std::vector<RayHit> hits[MODE_COUNT];
+  double ms[MODE_COUNT] = {}, checksum[MODE_COUNT] = {};
+  long long steps[MODE_COUNT] = {};
+  // Packet hits must match scalar exactly; distance-field hits must land
+  // in the same cell and side, with distances a few ULPs apart at most
+  long long packetMismatches = 0, skipMismatches = 0;
+  double skipMaxError = 0.0;
+  for (auto &h : hits)
+    h.resize(SCREEN_WIDTH);
+
+  for (int f = 0; f < frames; f++) {
+    const View &v = views[f % views.size()];
+    double dx = std::cos(v.yaw), dy = std::sin(v.yaw);
+    for (int i = 0; i < SCREEN_WIDTH; i++) {
+      double cameraX = 2 * i / (double)SCREEN_WIDTH - 1;
+      dirX[i] = dx - 0.66 * dy * cameraX;
+      dirY[i] = dy + 0.66 * dx * cameraX;
+    }
+
+    for (int mode = 0; mode < MODE_COUNT; mode++) {
+      RayHit *out = hits[mode].data();
+      auto t0 = std::chrono::steady_clock::now();
+      if (mode == SCALAR) {
+        for (int i = 0; i < SCREEN_WIDTH; i++)
+          out[i] = tracer.Trace(v.x, v.y, dirX[i], dirY[i]);
+      } else if (mode == PACKET) {
+        tracer.TracePacket(v.x, v.y, dirX.data(), dirY.data(), SCREEN_WIDTH,
+                           out);
+      } else {
+        for (int i = 0; i < SCREEN_WIDTH; i++)
+          out[i] = tracer.TraceSkipping(v.x, v.y, dirX[i], dirY[i]);
+      }
+      auto t1 = std::chrono::steady_clock::now();
+      ms[mode] += std::chrono::duration<double, std::milli>(t1 - t0).count();
+      checksum[mode] += Checksum(hits[mode]);
+      for (const RayHit &h : hits[mode])
+        steps[mode] += h.steps;
+    }
+
+    for (int i = 0; i < SCREEN_WIDTH; i++) {
+      const RayHit &a = hits[SCALAR][i];
+      const RayHit &b = hits[PACKET][i];
+      const RayHit &c = hits[SKIPPING][i];
+      if (a.dist != b.dist || a.side != b.side || a.mapX != b.mapX ||
+          a.mapY != b.mapY)
+        packetMismatches++;
+      if (a.side != c.side || a.mapX != c.mapX || a.mapY != c.mapY)
+        skipMismatches++;
+      else
+        skipMaxError = std::max(skipMaxError, std::abs(a.dist - c.dist));
+    }
+  }
+
+  double rays = (double)frames * SCREEN_WIDTH;
+  std::printf("map %s, %d frames x %d rays\n", path, frames, SCREEN_WIDTH);
+  for (int mode = 0; mode < MODE_COUNT; mode++) {
+    std::printf("%-15s: %8.3f ms/frame  %7.2f Mrays/s  %5.2f steps/ray  "
+                "(checksum %.3f)\n",
+                names[mode], ms[mode] / frames, rays / (ms[mode] * 1000.0),
+                steps[mode] / rays, checksum[mode]);
+  }
+  std::printf("packet: %.2fx vs scalar, %lld mismatched rays\n",
+              ms[SCALAR] / ms[PACKET], packetMismatches);
+  std::printf("distance field: %.2fx vs scalar, %lld mismatched cells, "
+              "max distance error %g\n",
+              ms[SCALAR] / ms[SKIPPING], skipMismatches, skipMaxError);
+  return packetMismatches == 0 && skipMismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,153 @@
+// Compares the generic software wall loop against the kernels specialized
+// on the frame's features, over a few synthetic scenes.
+// Usage: WallKernelBench [frames]
+#include "engine/WallKernel.h"
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+using namespace PixelsEngine;
+
+namespace {
+
+const int SCREEN_WIDTH = 1280;
+const int SCREEN_HEIGHT = 720;
+const int TEXTURE_SIZE = 256;
+
+// A procedural wall image with its mip chain (2x2 box filter per level)
+struct WallImages {
+  std::vector<std::vector<Uint32>> levels;
+
+  explicit WallImages(unsigned seed) {
+    std::vector<Uint32> base(TEXTURE_SIZE * TEXTURE_SIZE);
+    for (int y = 0; y < TEXTURE_SIZE; y++) {
+      for (int x = 0; x < TEXTURE_SIZE; x++) {
+        unsigned v = (x * 73856093u) ^ (y * 19349663u) ^ seed;
+        v ^= v >> 13;
+        base[y * TEXTURE_SIZE + x] = 0xFF000000u | (v & 0xFFFFFFu);
+      }
+    }
+    levels.push_back(base);
+    for (int size = TEXTURE_SIZE / 2; size >= 8 && levels.size() < MAX_WALL_MIPS;
+         size /= 2) {
+      const std::vector<Uint32> &src = levels.back();
+      std::vector<Uint32> dst(size * size);
+      for (int y = 0; y < size; y++) {
+        for (int x = 0; x < size; x++) {
+          Uint32 sum[3] = {};
+          for (int k = 0; k < 4; k++) {
+            Uint32 c = src[(y * 2 + k / 2) * size * 2 + x * 2 + k % 2];
+            sum[0] += (c >> 16) & 0xFF;
+            sum[1] += (c >> 8) & 0xFF;
+            sum[2] += c & 0xFF;
+          }
+          dst[y * size + x] = 0xFF000000u | ((sum[0] / 4) << 16) |
+                              ((sum[1] / 4) << 8) | (sum[2] / 4);
+        }
+      }
+      levels.push_back(dst);
+    }
+  }
+
+  WallMaterial Material(Uint8 flags) const {
+    WallMaterial mat;
+    mat.flags = flags;
+    for (const auto &level : levels) {
+      int size = (int)std::sqrt((double)level.size());
+      mat.mips[mat.mipCount++] = {level.data(), size, size, size};
+    }
+    return mat;
+  }
+};
+
+struct Scene {
+  const char *name;
+  bool twoMaterials;
+  Uint8 flags;
+  float roll;
+  bool mipmaps;
+};
+
+unsigned long long Checksum(const std::vector<Uint32> &pixels) {
+  unsigned long long sum = 0;
+  for (Uint32 p : pixels)
+    sum = sum * 1000003ull + p;
+  return sum;
+}
+
+} // namespace
+
+int main(int argc, char **argv) {
+  int frames = argc > 1 ? std::atoi(argv[1]) : 200;
+
+  WallImages brick(1), moss(2);
+  Shading shading;
+  const Scene scenes[] = {
+      {"plain, one material", false, 0, 0.0f, false},
+      {"mips, one material", false, 0, 0.0f, true},
+      {"fog + side shade", true, MAT_SIDE_SHADE | MAT_FOG, 0.0f, true},
+      {"fog + side shade, roll", true, MAT_SIDE_SHADE | MAT_FOG, 4.0f, true},
+      {"fog, roll", true, MAT_FOG, 4.0f, true},
+  };
+
+  std::vector<double> dist(SCREEN_WIDTH);
+  std::vector<Uint8> side(SCREEN_WIDTH);
+  std::vector<int> texX(SCREEN_WIDTH), tile(SCREEN_WIDTH);
+  std::vector<Uint32> generic(SCREEN_WIDTH * SCREEN_HEIGHT);
+  std::vector<Uint32> specialized(SCREEN_WIDTH * SCREEN_HEIGHT);
+  long long mismatches = 0;
+
+  std::printf("%d frames at %dx%d\n", frames, SCREEN_WIDTH, SCREEN_HEIGHT);
+  for (const Scene &scene : scenes) {
+    WallMaterial materials[2] = {brick.Material(scene.flags),
+                                 moss.Material(scene.flags)};
+    WallFrame frame;
+    frame.width = SCREEN_WIDTH;
+    frame.height = SCREEN_HEIGHT;
+    frame.dist = dist.data();
+    frame.side = side.data();
+    frame.texX = texX.data();
+    frame.tile = tile.data();
+    frame.materials = materials;
+    frame.shading = &shading;
+    frame.camZ = 0.5f;
+    frame.roll = scene.roll;
+    frame.mipmaps = scene.mipmaps;
+
+    double ms[2] = {};
+    unsigned features = 0;
+    for (int f = 0; f < frames; f++) {
+      // Walls from a few tiles to across the map, in runs of one side
+      for (int x = 0; x < SCREEN_WIDTH; x++) {
+        double t = x * 0.004 + f * 0.05;
+        dist[x] = 0.4 + 6.0 * (0.5 + 0.5 * std::sin(t * 3.0));
+        side[x] = (Uint8)(((x + f) / 97) & 1);
+        texX[x] = (x * 7 + f) % TEXTURE_SIZE;
+        tile[x] = scene.twoMaterials ? ((x + f * 3) / 211) & 1 : 0;
+      }
+      frame.pitch = (f % 9) * 20 - 80;
+
+      auto t0 = std::chrono::steady_clock::now();
+      frame.pixels = generic.data();
+      DrawWallColumnsGeneric(frame, 0, SCREEN_WIDTH);
+      auto t1 = std::chrono::steady_clock::now();
+      frame.pixels = specialized.data();
+      features = GetWallFeatures(frame);
+      SelectWallKernel(features)(frame, 0, SCREEN_WIDTH);
+      auto t2 = std::chrono::steady_clock::now();
+      ms[0] += std::chrono::duration<double, std::milli>(t1 - t0).count();
+      ms[1] += std::chrono::duration<double, std::milli>(t2 - t1).count();
+
+      if (Checksum(generic) != Checksum(specialized))
+        mismatches++;
+    }
+    std::printf("%-24s: generic %7.3f ms/frame, %-28s %7.3f ms/frame "
+                "(%.2fx)\n",
+                scene.name, ms[0] / frames, GetWallFeatureName(features),
+                ms[1] / frames, ms[0] / ms[1]);
+  }
+  std::printf("%lld mismatched frames\n", mismatches);
+  return mismatches == 0 ? 0 : 1;
+}
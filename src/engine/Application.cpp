@@ -100,6 +100,7 @@ void Application::Run() {
 }
 
 void Application::Step() {
+  Uint64 startCounter = SDL_GetPerformanceCounter();
   Input::SetRenderer(m_Renderer);
   Input::BeginFrame();
 
@@ -131,6 +132,8 @@ void Application::Step() {
 
   OnRender();
 
+  m_FrameWorkMs = (SDL_GetPerformanceCounter() - startCounter) * 1000.0 /
+                  SDL_GetPerformanceFrequency();
   SDL_RenderPresent(m_Renderer);
 }
 
@@ -23,6 +23,10 @@ public:
   int GetWindowWidth() const { return m_Width; }
   int GetWindowHeight() const { return m_Height; }
 
+  // Time the last frame spent on events, update and render, leaving out the
+  // wait for vsync in SDL_RenderPresent
+  double GetFrameWorkMs() const { return m_FrameWorkMs; }
+
 protected:
   virtual void OnStart() {}
   virtual void OnUpdate(float deltaTime) {}
@@ -33,6 +37,7 @@ protected:
   int m_Width;
   int m_Height;
   Uint32 m_LastTime = 0;
+  double m_FrameWorkMs = 0.0;
   bool m_IsRunning = false;
   std::unique_ptr<Camera> m_Camera;
   Registry m_Registry;
@@ -0,0 +1,38 @@
+#include "DepthPyramid.h"
+#include <algorithm>
+
+namespace PixelsEngine {
+
+void DepthPyramid::Build(const std::vector<double> &depth) {
+  int n = (int)depth.size();
+  m_Size = n;
+  m_Min.resize(2 * n);
+  m_Max.resize(2 * n);
+  std::copy(depth.begin(), depth.end(), m_Min.begin() + n);
+  std::copy(depth.begin(), depth.end(), m_Max.begin() + n);
+  for (int i = n - 1; i > 0; i--) {
+    m_Min[i] = std::min(m_Min[2 * i], m_Min[2 * i + 1]);
+    m_Max[i] = std::max(m_Max[2 * i], m_Max[2 * i + 1]);
+  }
+}
+
+void DepthPyramid::Query(int x0, int x1, double &nearest,
+                         double &farthest) const {
+  nearest = m_Min[x0 + m_Size];
+  farthest = m_Max[x0 + m_Size];
+  // Climb from both ends, folding in every node that lies fully inside
+  for (int l = x0 + m_Size, r = x1 + m_Size; l < r; l >>= 1, r >>= 1) {
+    if (l & 1) {
+      nearest = std::min(nearest, m_Min[l]);
+      farthest = std::max(farthest, m_Max[l]);
+      l++;
+    }
+    if (r & 1) {
+      r--;
+      nearest = std::min(nearest, m_Min[r]);
+      farthest = std::max(farthest, m_Max[r]);
+    }
+  }
+}
+
+} // namespace PixelsEngine
@@ -0,0 +1,25 @@
+#pragma once
+#include <vector>
+
+namespace PixelsEngine {
+
+// Min/max pyramid over the per-column wall distances, stored as a bottom-up
+// binary tree. The nearest and farthest wall over any column range comes
+// out in O(log w) without touching every column.
+class DepthPyramid {
+public:
+  void Build(const std::vector<double> &depth);
+
+  // Nearest and farthest wall over columns [x0, x1). The range must be
+  // non-empty and inside the buffer that was built.
+  void Query(int x0, int x1, double &nearest, double &farthest) const;
+
+private:
+  // Implicit binary tree: leaves at [m_Size, 2 * m_Size), node i covers
+  // nodes 2i and 2i + 1
+  int m_Size = 0;
+  std::vector<double> m_Min;
+  std::vector<double> m_Max;
+};
+
+} // namespace PixelsEngine
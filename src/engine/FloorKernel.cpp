@@ -0,0 +1,278 @@
+#include "FloorKernel.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace PixelsEngine {
+
+namespace {
+
+struct FloorPalette {
+  Uint32 concrete;
+  Uint32 jumpPad;
+  Uint32 abyssLight;
+  Uint32 abyssDark;
+};
+
+inline Uint32 ShadeRGB(int r, int g, int b, float shade) {
+  int sr = std::min(255, (int)(r * shade));
+  int sg = std::min(255, (int)(g * shade));
+  int sb = std::min(255, (int)(b * shade));
+  return 0xFF000000u | ((Uint32)sr << 16) | ((Uint32)sg << 8) | (Uint32)sb;
+}
+
+FloorPalette MakePalette(float shade) {
+  return {ShadeRGB(100, 100, 110, shade), ShadeRGB(0, 200, 200, shade),
+          0xFF1E1E23u, 0xFF141419u};
+}
+
+inline Uint32 FlatFloorPixel(const FloorRow &row, const FloorPalette &pal,
+                             Uint8 flags, int x) {
+  if (flags & TILE_ABYSS) {
+    float dx = row.deepX + (float)x * row.deepStepX;
+    float dy = row.deepY + (float)x * row.deepStepY;
+    bool dark = (((int)dx + (int)dy) & 1) == 0;
+    return dark ? pal.abyssDark : pal.abyssLight;
+  }
+  return (flags & TILE_JUMP_PAD) ? pal.jumpPad : pal.concrete;
+}
+
+// The cell under pixel x, truncated toward zero like the SIMD paths'
+// cvttps; every floor kernel picks its tile through this expression
+inline void FloorCell(const FloorRow &row, int x, int &cx, int &cy) {
+  cx = (int)(row.floorX + (float)x * row.stepX);
+  cy = (int)(row.floorY + (float)x * row.stepY);
+}
+
+inline Uint32 FloorPixel(const FloorRow &row, const FloorPalette &pal,
+                         const Map &map, int x) {
+  int cx, cy;
+  FloorCell(row, x, cx, cy);
+  return FlatFloorPixel(row, pal, map.GetFlags(cx, cy), x);
+}
+
+// Texel times shade/256 per channel, saturated
+inline Uint32 ShadeTexel(Uint32 c, int shade) {
+  Uint32 r = std::min(255u, (((c >> 16) & 0xFF) * shade) >> 8);
+  Uint32 g = std::min(255u, (((c >> 8) & 0xFF) * shade) >> 8);
+  Uint32 b = std::min(255u, ((c & 0xFF) * shade) >> 8);
+  return 0xFF000000u | (r << 16) | (g << 8) | b;
+}
+
+inline Sint64 ToFixed32(float v) {
+  return (Sint64)std::floor((double)v * 4294967296.0 + 0.5);
+}
+
+} // namespace
+
+int FloorTextureSet::Add(const Uint32 *pixels, int width, int height) {
+  int index = (int)(m_Texels.size() / (SIZE * SIZE));
+  m_Texels.resize(m_Texels.size() + SIZE * SIZE);
+  Uint32 *dst = m_Texels.data() + (size_t)index * SIZE * SIZE;
+  for (int v = 0; v < SIZE; v++) {
+    const Uint32 *src = pixels + (v * height / SIZE) * width;
+    for (int u = 0; u < SIZE; u++)
+      dst[TexelIndex(u, v)] = src[u * width / SIZE];
+  }
+  return index;
+}
+
+namespace {
+
+// Abyss = false drops the abyss checkerboard for maps without abyss cells;
+// Ceiling = true leaves untextured tiles alone
+template <bool Abyss, bool Ceiling>
+void CastTexturedRow(const FloorRow &row, const Map &map,
+                     const Uint32 *const *tileTextures, Uint32 *dst,
+                     int width) {
+  const int texShift = 32 - FloorTextureSet::SIZE_LOG2;
+  const int texMask = FloorTextureSet::SIZE - 1;
+  FloorPalette pal = MakePalette(row.shade);
+  int shade = std::max(0, std::min(1024, (int)(row.shade * 256.0f)));
+  Sint64 fx = ToFixed32(row.floorX);
+  Sint64 fy = ToFixed32(row.floorY);
+  Sint64 stepX = ToFixed32(row.stepX);
+  Sint64 stepY = ToFixed32(row.stepY);
+
+  // The tile (and its texture) only changes when the row crosses a cell
+  int cellX = 0, cellY = 0;
+  Uint8 flags = 0;
+  const Uint32 *tex = nullptr;
+  bool first = true;
+  for (int x = 0; x < width; x++, fx += stepX, fy += stepY) {
+    // Texels step in fixed point, but the tile comes from the flat
+    // kernel's float expression so both agree on every cell edge
+    int cx, cy;
+    FloorCell(row, x, cx, cy);
+    if (first || cx != cellX || cy != cellY) {
+      first = false;
+      cellX = cx;
+      cellY = cy;
+      flags = map.GetFlags(cx, cy);
+      tex = tileTextures[map.Get(cx, cy) & 255];
+    }
+    if (tex) {
+      int u = (int)(fx >> texShift) & texMask;
+      int v = (int)(fy >> texShift) & texMask;
+      dst[x] = ShadeTexel(tex[FloorTextureSet::TexelIndex(u, v)], shade);
+    } else if (!Ceiling) {
+      dst[x] = Abyss ? FlatFloorPixel(row, pal, flags, x)
+                     : ((flags & TILE_JUMP_PAD) ? pal.jumpPad : pal.concrete);
+    }
+  }
+}
+
+} // namespace
+
+bool HasAbyssTiles(const Map &map) {
+  return map.AnyCell(Map::PLANE_ABYSS);
+}
+
+TexturedFloorKernel SelectTexturedFloorKernel(bool abyss, bool ceiling) {
+  if (ceiling)
+    return abyss ? &CastTexturedRow<true, true> : &CastTexturedRow<false, true>;
+  return abyss ? &CastTexturedRow<true, false> : &CastTexturedRow<false, false>;
+}
+
+void CastFloorRowScalar(const FloorRow &row, const Map &map, Uint32 *dst,
+                        int width) {
+  FloorPalette pal = MakePalette(row.shade);
+  for (int x = 0; x < width; x++)
+    dst[x] = FloorPixel(row, pal, map, x);
+}
+
+#if defined(__AVX2__)
+
+void CastFloorRow(const FloorRow &row, const Map &map, Uint32 *dst,
+                  int width) {
+  FloorPalette pal = MakePalette(row.shade);
+  const __m256 laneOffsets = _mm256_setr_ps(0, 1, 2, 3, 4, 5, 6, 7);
+  const __m256i mapW = _mm256_set1_epi32(Map::WIDTH);
+  const __m256i mapH = _mm256_set1_epi32(Map::HEIGHT);
+  const __m256i minusOne = _mm256_set1_epi32(-1);
+  const __m256i one = _mm256_set1_epi32(1);
+  const __m256i border = _mm256_set1_epi32(map.GetBorderFlags());
+  const __m256i padBit = _mm256_set1_epi32(TILE_JUMP_PAD);
+  const __m256i abyssBit = _mm256_set1_epi32(TILE_ABYSS);
+  const __m256i concrete = _mm256_set1_epi32((int)pal.concrete);
+  const __m256i jumpPad = _mm256_set1_epi32((int)pal.jumpPad);
+  const __m256i abyssLight = _mm256_set1_epi32((int)pal.abyssLight);
+  const __m256i abyssDark = _mm256_set1_epi32((int)pal.abyssDark);
+
+  int x = 0;
+  for (; x + 8 <= width; x += 8) {
+    __m256 xs = _mm256_add_ps(_mm256_set1_ps((float)x), laneOffsets);
+    __m256i cx = _mm256_cvttps_epi32(_mm256_add_ps(
+        _mm256_set1_ps(row.floorX), _mm256_mul_ps(xs, _mm256_set1_ps(row.stepX))));
+    __m256i cy = _mm256_cvttps_epi32(_mm256_add_ps(
+        _mm256_set1_ps(row.floorY), _mm256_mul_ps(xs, _mm256_set1_ps(row.stepY))));
+
+    // Lanes outside the map read the border's flags, like Map::GetFlags
+    __m256i inside = _mm256_and_si256(
+        _mm256_and_si256(_mm256_cmpgt_epi32(cx, minusOne),
+                         _mm256_cmpgt_epi32(mapW, cx)),
+        _mm256_and_si256(_mm256_cmpgt_epi32(cy, minusOne),
+                         _mm256_cmpgt_epi32(mapH, cy)));
+    __m256i index = _mm256_add_epi32(_mm256_mullo_epi32(cy, mapW), cx);
+    __m256i flags = _mm256_mask_i32gather_epi32(border, map.GetCellFlags(),
+                                                index, inside, 4);
+
+    __m256i dx = _mm256_cvttps_epi32(_mm256_add_ps(
+        _mm256_set1_ps(row.deepX), _mm256_mul_ps(xs, _mm256_set1_ps(row.deepStepX))));
+    __m256i dy = _mm256_cvttps_epi32(_mm256_add_ps(
+        _mm256_set1_ps(row.deepY), _mm256_mul_ps(xs, _mm256_set1_ps(row.deepStepY))));
+    __m256i odd = _mm256_and_si256(_mm256_add_epi32(dx, dy), one);
+    __m256i abyss = _mm256_blendv_epi8(
+        abyssDark, abyssLight, _mm256_cmpeq_epi32(odd, one));
+
+    __m256i isPad =
+        _mm256_cmpeq_epi32(_mm256_and_si256(flags, padBit), padBit);
+    __m256i isAbyss =
+        _mm256_cmpeq_epi32(_mm256_and_si256(flags, abyssBit), abyssBit);
+    __m256i color = _mm256_blendv_epi8(concrete, jumpPad, isPad);
+    color = _mm256_blendv_epi8(color, abyss, isAbyss);
+    _mm256_storeu_si256((__m256i *)(dst + x), color);
+  }
+  for (; x < width; x++)
+    dst[x] = FloorPixel(row, pal, map, x);
+}
+
+const char *GetFloorKernelName() { return "AVX2"; }
+
+#elif defined(__SSE2__)
+
+namespace {
+
+inline __m128i Select(__m128i mask, __m128i a, __m128i b) {
+  return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+} // namespace
+
+void CastFloorRow(const FloorRow &row, const Map &map, Uint32 *dst,
+                  int width) {
+  FloorPalette pal = MakePalette(row.shade);
+  const __m128 laneOffsets = _mm_setr_ps(0, 1, 2, 3);
+  const __m128i one = _mm_set1_epi32(1);
+  const __m128i padBit = _mm_set1_epi32(TILE_JUMP_PAD);
+  const __m128i abyssBit = _mm_set1_epi32(TILE_ABYSS);
+  const __m128i concrete = _mm_set1_epi32((int)pal.concrete);
+  const __m128i jumpPad = _mm_set1_epi32((int)pal.jumpPad);
+  const __m128i abyssLight = _mm_set1_epi32((int)pal.abyssLight);
+  const __m128i abyssDark = _mm_set1_epi32((int)pal.abyssDark);
+
+  alignas(16) int cellX[4];
+  alignas(16) int cellY[4];
+  alignas(16) int cellFlags[4];
+
+  int x = 0;
+  for (; x + 4 <= width; x += 4) {
+    __m128 xs = _mm_add_ps(_mm_set1_ps((float)x), laneOffsets);
+    _mm_store_si128((__m128i *)cellX,
+                    _mm_cvttps_epi32(_mm_add_ps(_mm_set1_ps(row.floorX),
+                                                _mm_mul_ps(xs, _mm_set1_ps(row.stepX)))));
+    _mm_store_si128((__m128i *)cellY,
+                    _mm_cvttps_epi32(_mm_add_ps(_mm_set1_ps(row.floorY),
+                                                _mm_mul_ps(xs, _mm_set1_ps(row.stepY)))));
+    // SSE2 has no gather; four scalar loads are still cheap
+    for (int i = 0; i < 4; i++)
+      cellFlags[i] = map.GetFlags(cellX[i], cellY[i]);
+    __m128i flags = _mm_load_si128((const __m128i *)cellFlags);
+
+    __m128i dx = _mm_cvttps_epi32(_mm_add_ps(
+        _mm_set1_ps(row.deepX), _mm_mul_ps(xs, _mm_set1_ps(row.deepStepX))));
+    __m128i dy = _mm_cvttps_epi32(_mm_add_ps(
+        _mm_set1_ps(row.deepY), _mm_mul_ps(xs, _mm_set1_ps(row.deepStepY))));
+    __m128i odd = _mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(dx, dy), one), one);
+    __m128i abyss = Select(odd, abyssLight, abyssDark);
+
+    __m128i isPad = _mm_cmpeq_epi32(_mm_and_si128(flags, padBit), padBit);
+    __m128i isAbyss =
+        _mm_cmpeq_epi32(_mm_and_si128(flags, abyssBit), abyssBit);
+    __m128i color = Select(isPad, jumpPad, concrete);
+    color = Select(isAbyss, abyss, color);
+    _mm_storeu_si128((__m128i *)(dst + x), color);
+  }
+  for (; x < width; x++)
+    dst[x] = FloorPixel(row, pal, map, x);
+}
+
+const char *GetFloorKernelName() { return "SSE2"; }
+
+#else
+
+void CastFloorRow(const FloorRow &row, const Map &map, Uint32 *dst,
+                  int width) {
+  CastFloorRowScalar(row, map, dst, width);
+}
+
+const char *GetFloorKernelName() { return "Scalar"; }
+
+#endif
+
+} // namespace PixelsEngine
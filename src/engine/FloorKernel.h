@@ -0,0 +1,75 @@
+#pragma once
+#include "Map.h"
+#include <SDL2/SDL.h>
+#include <vector>
+
+namespace PixelsEngine {
+
+// One screen row of floor casting. Floor and abyss positions are linear in
+// x, so each is described by its value at x = 0 plus a per-pixel step.
+struct FloorRow {
+  float floorX, floorY; // Rooftop position under pixel 0
+  float stepX, stepY;
+  float deepX, deepY; // Abyss ground position under pixel 0
+  float deepStepX, deepStepY;
+  float shade; // Row shadow * ambient pulse, applied to rooftop tiles
+};
+
+// Writes `width` ARGB8888 pixels for one floor row. Uses AVX2 (8 pixels per
+// iteration) or SSE2 (4 pixels) when the build targets them; the scalar
+// path produces identical output.
+void CastFloorRow(const FloorRow &row, const Map &map, Uint32 *dst, int width);
+
+// Reference implementation, always available
+void CastFloorRowScalar(const FloorRow &row, const Map &map, Uint32 *dst,
+                        int width);
+
+const char *GetFloorKernelName();
+
+// Floor and ceiling images resampled to SIZE x SIZE and stored as 8x8 texel
+// blocks, so the texels one floor row touches stay within a few cache lines
+// whichever way the row crosses the texture.
+class FloorTextureSet {
+public:
+  static const int SIZE_LOG2 = 6;
+  static const int SIZE = 1 << SIZE_LOG2;
+  static const int BLOCK_LOG2 = 3;
+
+  // Adds an ARGB8888 image (nearest-resampled if it is not SIZE x SIZE) and
+  // returns its index. Earlier Get() pointers are invalidated.
+  int Add(const Uint32 *pixels, int width, int height);
+  void Clear() { m_Texels.clear(); }
+  const Uint32 *Get(int index) const {
+    return m_Texels.data() + (size_t)index * SIZE * SIZE;
+  }
+
+  // Offset of texel (u, v) inside one texture
+  static int TexelIndex(int u, int v) {
+    const int mask = (1 << BLOCK_LOG2) - 1;
+    return ((v >> BLOCK_LOG2) << (SIZE_LOG2 + BLOCK_LOG2)) |
+           ((u >> BLOCK_LOG2) << (BLOCK_LOG2 * 2)) | ((v & mask) << BLOCK_LOG2) |
+           (u & mask);
+  }
+
+private:
+  std::vector<Uint32> m_Texels;
+};
+
+// One textured floor (or ceiling) row. Texel coordinates step along the row
+// in 32.32 fixed point; tiles are picked exactly as CastFloorRow picks them,
+// and each takes its texture from tileTextures (indexed by tile & 255, from
+// FloorTextureSet::Get). Floor tiles without a
+// texture get the flat colours of CastFloorRow; ceiling tiles without one
+// are left untouched so the sky shows through.
+using TexturedFloorKernel = void (*)(const FloorRow &row, const Map &map,
+                                     const Uint32 *const *tileTextures,
+                                     Uint32 *dst, int width);
+
+// The textured row compiled for one case, picked once per frame. The
+// abyss-free variant draws abyss cells as concrete, so it is only correct
+// for maps where HasAbyssTiles() is false.
+TexturedFloorKernel SelectTexturedFloorKernel(bool abyss, bool ceiling);
+// Whether any cell (or the border) has TILE_ABYSS; tests the plane words
+bool HasAbyssTiles(const Map &map);
+
+} // namespace PixelsEngine
@@ -1,17 +1,50 @@
 #pragma once
+#include <SDL2/SDL.h>
+#include <algorithm>
 #include <cstdio>
+#include <cstring>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace PixelsEngine {
 
+// Gameplay properties of a tile ID
+enum TileFlags : Uint8 {
+  TILE_BLOCKS_RAY = 1 << 0, // Walls: stop rays, players and the camera
+  TILE_RUNNABLE = 1 << 1,   // Walls that can be wall-run
+  TILE_JUMP_PAD = 1 << 2,
+  TILE_ABYSS = 1 << 3, // Floor gap the player falls through
+};
+
 struct Map {
   static const int WIDTH = 24;
   static const int HEIGHT = 24;
 
-  // 0 = empty, >0 = wall texture ID
+  // 0 = empty, >0 = wall texture ID. Write through Set() so the bit planes
+  // below stay in sync.
   int tiles[WIDTH * HEIGHT];
 
+  // Bit-packed copies of the tile flags, one bit per cell. The planes carry
+  // a one-cell border that reads like tile 1 (what Get() reports out of
+  // bounds), so queries clamp instead of branching on the bounds. Plane N
+  // holds bit N of TileFlags.
+  enum Plane { PLANE_BLOCKS_RAY, PLANE_RUNNABLE, PLANE_JUMP_PAD, PLANE_ABYSS,
+               PLANE_COUNT };
+  static const int PADDED_WIDTH = WIDTH + 2;
+  static const int PADDED_HEIGHT = HEIGHT + 2;
+  static const int ROW_WORDS = (PADDED_WIDTH + 63) / 64;
+
+  Map() {
+    std::memset(tiles, 0, sizeof(tiles));
+    std::memset(tileFlags, 0, sizeof(tileFlags));
+    tileFlags[1] = TILE_BLOCKS_RAY;
+    tileFlags[2] = TILE_BLOCKS_RAY | TILE_RUNNABLE;
+    tileFlags[3] = TILE_JUMP_PAD;
+    tileFlags[4] = TILE_ABYSS;
+    RebuildPlanes();
+  }
+
   int Get(int x, int y) const {
     if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
       return 1; // Out of bounds is wall
@@ -21,25 +54,174 @@ struct Map {
   void Set(int x, int y, int val) {
     if (x >= 0 && x < WIDTH && y >= 0 && y < HEIGHT) {
       tiles[y * WIDTH + x] = val;
+      WriteCell(x + 1, y + 1, tileFlags[val & 255]);
+      wallDistanceDirty = true; // Rebuilt once, on the next read
+      revision++;
+    }
+  }
+
+  bool Test(Plane plane, int x, int y) const {
+    int px = std::min(std::max(x + 1, 0), PADDED_WIDTH - 1);
+    int py = std::min(std::max(y + 1, 0), PADDED_HEIGHT - 1);
+    return (planes[plane][py * ROW_WORDS + (px >> 6)] >> (px & 63)) & 1;
+  }
+  bool BlocksRay(int x, int y) const { return Test(PLANE_BLOCKS_RAY, x, y); }
+  bool IsRunnable(int x, int y) const { return Test(PLANE_RUNNABLE, x, y); }
+  bool IsJumpPad(int x, int y) const { return Test(PLANE_JUMP_PAD, x, y); }
+  bool IsAbyss(int x, int y) const { return Test(PLANE_ABYSS, x, y); }
+
+  // Whether any cell, border included, has the plane's flag
+  bool AnyCell(Plane plane) const {
+    for (Uint64 word : planes[plane]) {
+      if (word)
+        return true;
     }
+    return false;
+  }
+
+  // TileFlags of every cell, row-major like `tiles`, as 32-bit values so
+  // SIMD kernels can gather them. Cells out of bounds have GetBorderFlags().
+  const Sint32 *GetCellFlags() const { return cellFlags; }
+  Uint8 GetBorderFlags() const { return tileFlags[1] | TILE_BLOCKS_RAY; }
+  Uint8 GetFlags(int x, int y) const {
+    if (x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
+      return GetBorderFlags();
+    return (Uint8)cellFlags[y * WIDTH + x];
+  }
+
+  // Chebyshev distance from a cell to the nearest ray-blocking cell (the
+  // border counts). Every cell within distance - 1 of this one is empty, so
+  // rays can cross that square without looking at it. 0 for walls.
+  // Rebuilt on the first call after the walls change, so a batch of Set()
+  // calls costs one rebuild. That first call must not race other readers.
+  int GetWallDistance(int x, int y) const {
+    if (wallDistanceDirty)
+      RebuildWallDistance();
+    int px = std::min(std::max(x + 1, 0), PADDED_WIDTH - 1);
+    int py = std::min(std::max(y + 1, 0), PADDED_HEIGHT - 1);
+    return wallDistance[py * PADDED_WIDTH + px];
+  }
+
+  // Potentially visible set: HEIGHT row masks per cell, where bit x of row
+  // y is set when cell (x, y) may be seen from somewhere in the cell. Set
+  // by BuildMapVisibility / LoadMapVisibility (MapVisibility.h) and void
+  // after any change to the map. Without one every cell counts as visible.
+  bool HasVisibility() const {
+    return !visibility.empty() && visibilityRevision == revision;
+  }
+  const Uint64 *GetVisibleRows(int x, int y) const {
+    if (!HasVisibility() || x < 0 || x >= WIDTH || y < 0 || y >= HEIGHT)
+      return nullptr;
+    return visibility.data() + (size_t)(y * WIDTH + x) * HEIGHT;
+  }
+  bool CanSee(int fromX, int fromY, int toX, int toY) const {
+    const Uint64 *rows = GetVisibleRows(fromX, fromY);
+    if (!rows || toX < 0 || toX >= WIDTH || toY < 0 || toY >= HEIGHT)
+      return true;
+    return (rows[toY] >> toX) & 1;
+  }
+  void SetVisibility(std::vector<Uint64> rows) {
+    visibility = std::move(rows);
+    visibilityRevision = revision;
   }
 
+  // Changes what a tile ID means and rebuilds the planes
+  void SetTileFlags(int tile, Uint8 flags) {
+    tileFlags[tile & 255] = flags;
+    RebuildPlanes();
+  }
+  Uint8 GetTileFlags(int tile) const { return tileFlags[tile & 255]; }
+
+  // Bumped on every change so derived data can tell when to rebuild
+  unsigned GetRevision() const { return revision; }
+
   bool LoadFromFile(const std::string &path) {
     FILE *f = fopen(path.c_str(), "r");
     if (!f)
       return false;
-    for (int y = 0; y < HEIGHT; y++) {
-      for (int x = 0; x < WIDTH; x++) {
-        int val;
-        if (fscanf(f, "%d", &val) != 1) {
-          fclose(f);
-          return false;
-        }
-        Set(x, y, val);
-      }
+    bool ok = true;
+    for (int i = 0; i < WIDTH * HEIGHT && ok; i++) {
+      int val;
+      if (fscanf(f, "%d", &val) != 1)
+        ok = false;
+      else
+        tiles[i] = val;
     }
     fclose(f);
-    return true;
+    RebuildPlanes();
+    return ok;
+  }
+
+private:
+  Uint8 tileFlags[256];
+  Uint64 planes[PLANE_COUNT][PADDED_HEIGHT * ROW_WORDS];
+  mutable Uint8 wallDistance[PADDED_WIDTH * PADDED_HEIGHT];
+  mutable bool wallDistanceDirty = true;
+  Sint32 cellFlags[WIDTH * HEIGHT];
+  unsigned revision = 0;
+  static_assert(WIDTH <= 64, "visible cell rows are one Uint64");
+  std::vector<Uint64> visibility;
+  unsigned visibilityRevision = 0;
+
+  // Padded coordinates; border cells always block rays
+  void WriteCell(int px, int py, Uint8 flags) {
+    if (px >= 1 && px <= WIDTH && py >= 1 && py <= HEIGHT)
+      cellFlags[(py - 1) * WIDTH + px - 1] = flags;
+    Uint64 bit = (Uint64)1 << (px & 63);
+    int word = py * ROW_WORDS + (px >> 6);
+    for (int p = 0; p < PLANE_COUNT; p++) {
+      if (flags & (1 << p))
+        planes[p][word] |= bit;
+      else
+        planes[p][word] &= ~bit;
+    }
+  }
+
+  void RebuildPlanes() {
+    std::memset(planes, 0, sizeof(planes));
+    Uint8 border = GetBorderFlags();
+    for (int py = 0; py < PADDED_HEIGHT; py++) {
+      for (int px = 0; px < PADDED_WIDTH; px++) {
+        bool inside = px >= 1 && px <= WIDTH && py >= 1 && py <= HEIGHT;
+        WriteCell(px, py,
+                  inside ? tileFlags[tiles[(py - 1) * WIDTH + px - 1] & 255]
+                         : border);
+      }
+    }
+    wallDistanceDirty = true;
+    revision++;
+  }
+
+  // Two-pass chamfer over the padded grid. With unit weights on all eight
+  // neighbours this gives the exact Chebyshev distance.
+  void RebuildWallDistance() const {
+    const int W = PADDED_WIDTH;
+    for (int py = 0; py < PADDED_HEIGHT; py++) {
+      for (int px = 0; px < W; px++)
+        wallDistance[py * W + px] =
+            Test(PLANE_BLOCKS_RAY, px - 1, py - 1) ? 0 : 255;
+    }
+    for (int py = 1; py < PADDED_HEIGHT - 1; py++) {
+      for (int px = 1; px < W - 1; px++) {
+        Uint8 &d = wallDistance[py * W + px];
+        int n = std::min({wallDistance[py * W + px - 1],
+                          wallDistance[(py - 1) * W + px - 1],
+                          wallDistance[(py - 1) * W + px],
+                          wallDistance[(py - 1) * W + px + 1]}) + 1;
+        d = (Uint8)std::min((int)d, n);
+      }
+    }
+    for (int py = PADDED_HEIGHT - 2; py >= 1; py--) {
+      for (int px = W - 2; px >= 1; px--) {
+        Uint8 &d = wallDistance[py * W + px];
+        int n = std::min({wallDistance[py * W + px + 1],
+                          wallDistance[(py + 1) * W + px + 1],
+                          wallDistance[(py + 1) * W + px],
+                          wallDistance[(py + 1) * W + px - 1]}) + 1;
+        d = (Uint8)std::min((int)d, n);
+      }
+    }
+    wallDistanceDirty = false;
   }
 };
 
@@ -0,0 +1,285 @@
+#include "MapVisibility.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <numeric>
+#include <utility>
+#include <vector>
+
+namespace PixelsEngine {
+
+namespace {
+
+// Bump when the construction below changes so old caches are rebuilt
+const char CACHE_MAGIC[4] = {'P', 'V', 'S', '2'};
+const Uint64 ROW_MASK = Map::WIDTH == 64 ? ~(Uint64)0
+                                         : ((Uint64)1 << Map::WIDTH) - 1;
+const size_t SET_WORDS = (size_t)Map::WIDTH * Map::HEIGHT * Map::HEIGHT;
+
+// Walls are the interior of the union of blocking cells (and everything
+// outside the map), so a sight line may graze a wall but not cross one.
+// If any segment joins two cells without crossing a wall, sliding and then
+// turning it until it meets grid corners keeps it clear, so some clear
+// segment lies on a line through two grid corners. Walking every such line
+// and marking the cells along each clear stretch as seeing each other
+// therefore finds every pair of cells that can see each other, plus a few
+// that only see each other through a single point.
+class LineWalker {
+public:
+  LineWalker(const Map &map, Uint64 *sets) : m_Map(map), m_Sets(sets) {}
+
+  // The line through corner (x0, y0) in direction (dx, dy), with dx > 0 or
+  // (dx, dy) = (0, 1), and gcd(dx, dy) = 1
+  void Walk(int x0, int y0, int dx, int dy) {
+    // Positions are kept as integers scaled by L, so t = T / L
+    int ady = std::abs(dy);
+    int L = dx && dy ? dx * ady : (dx ? dx : 1);
+    int stepX = dx ? L / dx : 0; // T between x = integer crossings
+    int stepY = dy ? L / ady : 0;
+    // Clip to the map box, whose edges are grid lines
+    int lo = -1 << 30, hi = 1 << 30;
+    if (dx) {
+      lo = std::max(lo, -x0 * stepX);
+      hi = std::min(hi, (Map::WIDTH - x0) * stepX);
+    }
+    if (dy > 0) {
+      lo = std::max(lo, -y0 * stepY);
+      hi = std::min(hi, (Map::HEIGHT - y0) * stepY);
+    } else if (dy < 0) {
+      lo = std::max(lo, -(Map::HEIGHT - y0) * stepY);
+      hi = std::min(hi, y0 * stepY);
+    }
+    m_X0 = x0;
+    m_Y0 = y0;
+    m_DX = dx;
+    m_DY = dy;
+    m_L = L;
+    Clear();
+
+    // Every grid-line crossing in order; between two of them the line is
+    // inside one cell (or along one edge)
+    int nextX = stepX ? lo + Mod(-lo, stepX) : hi + 1;
+    int nextY = stepY ? lo + Mod(-lo, stepY) : hi + 1;
+    int t = lo;
+    Visit(2 * t);
+    while (t < hi) {
+      while (nextX <= t)
+        nextX += stepX;
+      while (nextY <= t)
+        nextY += stepY;
+      int next = std::min(hi, std::min(nextX, nextY));
+      Visit(t + next); // The open piece, by its midpoint
+      Visit(2 * next);
+      t = next;
+    }
+    Flush();
+  }
+
+private:
+  static int Mod(int a, int m) { return ((a % m) + m) % m; }
+
+  // The point of the line at t = t2 / (2 * L). Points on a grid line touch
+  // the cells on both sides of it.
+  void Visit(int t2) {
+    int k = 2 * m_L;
+    int xs = k * m_X0 + t2 * m_DX;
+    int ys = k * m_Y0 + t2 * m_DY;
+    int cx = FloorDiv(xs, k), cy = FloorDiv(ys, k);
+    bool edgeX = xs % k == 0, edgeY = ys % k == 0;
+    int x0 = edgeX ? cx - 1 : cx, y0 = edgeY ? cy - 1 : cy;
+    bool wall = true;
+    for (int y = y0; y <= cy; y++) {
+      for (int x = x0; x <= cx; x++)
+        wall = wall && m_Map.BlocksRay(x, y);
+    }
+    if (wall) {
+      Flush();
+      return;
+    }
+    for (int y = std::max(0, y0); y <= std::min(Map::HEIGHT - 1, cy); y++) {
+      for (int x = std::max(0, x0); x <= std::min(Map::WIDTH - 1, cx); x++) {
+        m_Stretch[y] |= (Uint64)1 << x;
+        m_MinY = std::min(m_MinY, y);
+        m_MaxY = std::max(m_MaxY, y);
+      }
+    }
+  }
+
+  static int FloorDiv(int a, int b) {
+    return a >= 0 ? a / b : -((-a + b - 1) / b);
+  }
+
+  // Every open cell on the stretch sees every cell on it
+  void Flush() {
+    for (int y = m_MinY; y <= m_MaxY; y++) {
+      for (Uint64 bits = m_Stretch[y]; bits; bits &= bits - 1) {
+        int x = __builtin_ctzll(bits);
+        if (m_Map.BlocksRay(x, y))
+          continue;
+        Uint64 *rows = m_Sets + (size_t)(y * Map::WIDTH + x) * Map::HEIGHT;
+        for (int ty = m_MinY; ty <= m_MaxY; ty++)
+          rows[ty] |= m_Stretch[ty];
+      }
+    }
+    Clear();
+  }
+
+  void Clear() {
+    for (int y = m_MinY; y <= m_MaxY; y++)
+      m_Stretch[y] = 0;
+    m_MinY = Map::HEIGHT;
+    m_MaxY = -1;
+  }
+
+  const Map &m_Map;
+  Uint64 *m_Sets;
+  Uint64 m_Stretch[Map::HEIGHT] = {};
+  int m_MinY = 0, m_MaxY = Map::HEIGHT - 1;
+  int m_X0 = 0, m_Y0 = 0, m_DX = 0, m_DY = 0, m_L = 1;
+};
+
+// Directions of the lines through two grid corners, one per line family
+std::vector<std::pair<int, int>> LineDirections() {
+  std::vector<std::pair<int, int>> dirs;
+  for (int dx = 0; dx <= Map::WIDTH; dx++) {
+    for (int dy = -Map::HEIGHT; dy <= Map::HEIGHT; dy++) {
+      if ((dx == 0 && dy != 1) || std::gcd(dx, std::abs(dy)) != 1)
+        continue;
+      dirs.push_back({dx, dy});
+    }
+  }
+  return dirs;
+}
+
+// Walks the lines of one direction: each starts at its first grid corner
+// inside the map and must reach at least one more
+void WalkDirection(LineWalker &walker, int dx, int dy) {
+  auto inside = [](int x, int y) {
+    return x >= 0 && x <= Map::WIDTH && y >= 0 && y <= Map::HEIGHT;
+  };
+  for (int y = 0; y <= Map::HEIGHT; y++) {
+    for (int x = 0; x <= Map::WIDTH; x++) {
+      if (!inside(x - dx, y - dy) && inside(x + dx, y + dy))
+        walker.Walk(x, y, dx, dy);
+    }
+  }
+}
+
+// One cell of margin in every direction
+void Dilate(Uint64 *rows) {
+  Uint64 exact[Map::HEIGHT];
+  std::copy(rows, rows + Map::HEIGHT, exact);
+  for (int y = 0; y < Map::HEIGHT; y++) {
+    Uint64 row = 0;
+    for (int ny = std::max(0, y - 1); ny <= std::min(Map::HEIGHT - 1, y + 1);
+         ny++)
+      row |= exact[ny] | (exact[ny] << 1) | (exact[ny] >> 1);
+    rows[y] = row & ROW_MASK;
+  }
+}
+
+// FNV-1a over which cells block rays, the only input the sets depend on
+Uint32 HashWalls(const Map &map) {
+  Uint32 hash = 2166136261u;
+  for (int y = 0; y < Map::HEIGHT; y++) {
+    for (int x = 0; x < Map::WIDTH; x++) {
+      hash ^= map.BlocksRay(x, y) ? 1u : 0u;
+      hash *= 16777619u;
+    }
+  }
+  return hash;
+}
+
+struct CacheHeader {
+  char magic[4];
+  Uint32 width;
+  Uint32 height;
+  Uint32 walls;
+};
+
+} // namespace
+
+void BuildMapVisibility(Map &map, ThreadPool *pool) {
+  std::vector<Uint64> rows(SET_WORDS);
+  std::vector<std::pair<int, int>> dirs = LineDirections();
+  std::mutex merge;
+  auto walkDirections = [&](int begin, int end) {
+    std::vector<Uint64> local(SET_WORDS);
+    LineWalker walker(map, local.data());
+    for (int i = begin; i < end; i++)
+      WalkDirection(walker, dirs[i].first, dirs[i].second);
+    std::lock_guard<std::mutex> lock(merge);
+    for (size_t i = 0; i < SET_WORDS; i++)
+      rows[i] |= local[i];
+  };
+  int count = (int)dirs.size();
+  if (pool) {
+    pool->ParallelFor(count, 16, walkDirections);
+  } else {
+    ThreadPool temporary;
+    temporary.ParallelFor(count, 16, walkDirections);
+  }
+
+  for (int i = 0; i < Map::WIDTH * Map::HEIGHT; i++) {
+    Uint64 *cell = rows.data() + (size_t)i * Map::HEIGHT;
+    if (map.BlocksRay(i % Map::WIDTH, i / Map::WIDTH)) {
+      // Never stood in, so nothing is ruled out
+      std::fill(cell, cell + Map::HEIGHT, ROW_MASK);
+      continue;
+    }
+    Dilate(cell);
+  }
+  map.SetVisibility(std::move(rows));
+}
+
+bool SaveMapVisibility(const Map &map, const std::string &path) {
+  if (!map.HasVisibility())
+    return false;
+  FILE *f = fopen(path.c_str(), "wb");
+  if (!f) {
+    std::cerr << "Failed to write visibility cache " << path << std::endl;
+    return false;
+  }
+  CacheHeader header = {{CACHE_MAGIC[0], CACHE_MAGIC[1], CACHE_MAGIC[2],
+                         CACHE_MAGIC[3]},
+                        Map::WIDTH,
+                        Map::HEIGHT,
+                        HashWalls(map)};
+  bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+            fwrite(map.GetVisibleRows(0, 0), sizeof(Uint64), SET_WORDS, f) ==
+                SET_WORDS;
+  ok = fclose(f) == 0 && ok;
+  if (!ok)
+    std::cerr << "Failed to write visibility cache " << path << std::endl;
+  return ok;
+}
+
+bool LoadMapVisibility(Map &map, const std::string &path) {
+  FILE *f = fopen(path.c_str(), "rb");
+  if (!f)
+    return false;
+  CacheHeader header;
+  std::vector<Uint64> rows(SET_WORDS);
+  bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+            std::equal(CACHE_MAGIC, CACHE_MAGIC + 4, header.magic) &&
+            header.width == (Uint32)Map::WIDTH &&
+            header.height == (Uint32)Map::HEIGHT &&
+            header.walls == HashWalls(map) &&
+            fread(rows.data(), sizeof(Uint64), rows.size(), f) == rows.size();
+  fclose(f);
+  if (ok)
+    map.SetVisibility(std::move(rows));
+  return ok;
+}
+
+void LoadOrBuildMapVisibility(Map &map, const std::string &cachePath) {
+  if (!cachePath.empty() && LoadMapVisibility(map, cachePath))
+    return;
+  BuildMapVisibility(map);
+  if (!cachePath.empty())
+    SaveMapVisibility(map, cachePath);
+}
+
+} // namespace PixelsEngine
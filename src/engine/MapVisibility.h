@@ -0,0 +1,27 @@
+#pragma once
+#include "Map.h"
+#include "ThreadPool.h"
+#include <string>
+
+namespace PixelsEngine {
+
+// Fills the map's potentially visible sets. The sets are conservative: a
+// cell is left out only if every segment from the source cell to it crosses
+// a wall. Every line through two grid corners is walked once, and the cells
+// along each stretch of it that crosses no wall are marked as seeing each
+// other. Each set then grows by one cell so anything that straddles a cell
+// border (a sprite up to two units wide) is kept. Lines are split across
+// the pool's threads; without a pool a temporary one is used.
+void BuildMapVisibility(Map &map, ThreadPool *pool = nullptr);
+
+// The sets in a cache file, tagged with the map's walls so a stale cache
+// is rejected instead of used
+bool SaveMapVisibility(const Map &map, const std::string &path);
+bool LoadMapVisibility(Map &map, const std::string &path);
+
+// Loads the cache at cachePath when it matches the map, otherwise builds
+// the sets and writes that file for the next load. An empty path builds
+// without a cache.
+void LoadOrBuildMapVisibility(Map &map, const std::string &cachePath);
+
+} // namespace PixelsEngine
@@ -0,0 +1,296 @@
+#include "PostProcess.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace PixelsEngine {
+
+namespace {
+
+// Vignette in output pixels: black at alpha 60 over the sides, 40 over the
+// top and bottom edges
+const int VIGNETTE_SIDE = 80;
+const int VIGNETTE_EDGE = 40;
+const Uint8 VIGNETTE_SIDE_ALPHA = 60;
+const Uint8 VIGNETTE_EDGE_ALPHA = 40;
+
+// c * mul + add, per channel, in floating point while effects are composed
+struct Blend {
+  float mul = 1.0f;
+  float add[3] = {0.0f, 0.0f, 0.0f};
+
+  // The result of drawing `color` with its alpha over this blend
+  void Over(SDL_Color color) {
+    float a = color.a / 255.0f;
+    mul *= 1.0f - a;
+    float rgb[3] = {(float)color.r, (float)color.g, (float)color.b};
+    for (int i = 0; i < 3; i++)
+      add[i] = add[i] * (1.0f - a) + rgb[i] * a;
+  }
+
+  bool IsIdentity() const {
+    return mul == 1.0f && add[0] == 0.0f && add[1] == 0.0f && add[2] == 0.0f;
+  }
+};
+
+inline Uint32 BlendPixel(Uint32 c, int mul, const int add[3]) {
+  Uint32 r = (Uint32)std::min(65535, (int)((c >> 16) & 0xFF) * mul + add[0]);
+  Uint32 g = (Uint32)std::min(65535, (int)((c >> 8) & 0xFF) * mul + add[1]);
+  Uint32 b = (Uint32)std::min(65535, (int)(c & 0xFF) * mul + add[2]);
+  return 0xFF000000u | ((r >> 8) << 16) | ((g >> 8) << 8) | (b >> 8);
+}
+
+inline int Clamp255(int v) { return std::max(0, std::min(255, v)); }
+
+} // namespace
+
+void PostProcess::BuildRegions(const PostEffects &fx, int w, int h, int outW,
+                               int outH) {
+  m_Regions.clear();
+  int sideW = 0, edgeH = 0;
+  if (fx.vignette) {
+    sideW = std::min(w, VIGNETTE_SIDE * w / std::max(1, outW));
+    edgeH = std::min(h, VIGNETTE_EDGE * h / std::max(1, outH));
+  }
+  bool focus = fx.focus.a > 0;
+  // The overlay scaled to this frame, at least one pixel across
+  SDL_Rect overlay = {0, 0, 0, 0};
+  if (fx.overlay.w > 0 && fx.overlay.h > 0) {
+    int ow = std::max(1, outW), oh = std::max(1, outH);
+    overlay.x = fx.overlay.x * w / ow;
+    overlay.y = fx.overlay.y * h / oh;
+    overlay.w = std::max(1, fx.overlay.w * w / ow);
+    overlay.h = std::max(1, fx.overlay.h * h / oh);
+  }
+  bool hasOverlay = overlay.w > 0;
+
+  // Every boundary an effect introduces, along each axis
+  std::vector<int> xs = {0, w, sideW, w - sideW};
+  std::vector<int> ys = {0, h, edgeH, h - edgeH};
+  if (focus) {
+    xs.insert(xs.end(), {w / 4, w / 4 + w / 2});
+    ys.insert(ys.end(), {h / 4, h / 4 + h / 2});
+  }
+  if (hasOverlay) {
+    xs.insert(xs.end(), {overlay.x, overlay.x + overlay.w});
+    ys.insert(ys.end(), {overlay.y, overlay.y + overlay.h});
+  }
+  for (auto *cuts : {&xs, &ys}) {
+    int limit = cuts == &xs ? w : h;
+    for (int &c : *cuts)
+      c = std::max(0, std::min(limit, c));
+    std::sort(cuts->begin(), cuts->end());
+    cuts->erase(std::unique(cuts->begin(), cuts->end()), cuts->end());
+  }
+
+  for (size_t j = 0; j + 1 < ys.size(); j++) {
+    int y0 = ys[j], y1 = ys[j + 1];
+    for (size_t i = 0; i + 1 < xs.size(); i++) {
+      int x0 = xs[i], x1 = xs[i + 1];
+      // Same order the effects used to be drawn in
+      Blend blend;
+      if (x0 < sideW || x0 >= w - sideW)
+        blend.Over({0, 0, 0, VIGNETTE_SIDE_ALPHA});
+      if (y0 < edgeH || y0 >= h - edgeH)
+        blend.Over({0, 0, 0, VIGNETTE_EDGE_ALPHA});
+      if (hasOverlay && x0 >= overlay.x && x0 < overlay.x + overlay.w &&
+          y0 >= overlay.y && y0 < overlay.y + overlay.h)
+        blend.Over({fx.overlayColor.r, fx.overlayColor.g, fx.overlayColor.b,
+                    255});
+      blend.Over(fx.tint);
+      if (focus && x0 >= w / 4 && x0 < w / 4 + w / 2 && y0 >= h / 4 &&
+          y0 < h / 4 + h / 2)
+        blend.Over(fx.focus);
+      blend.Over(fx.flash);
+      if (blend.IsIdentity())
+        continue;
+
+      Region region;
+      region.rect = {x0, y0, x1 - x0, y1 - y0};
+      region.mul = (int)std::lround(blend.mul * 256.0f);
+      for (int c = 0; c < 3; c++)
+        region.add[c] = (int)std::lround(blend.add[c] * 256.0f) + 128;
+      // Neighbours in a row with the same blend become one region
+      if (!m_Regions.empty()) {
+        Region &prev = m_Regions.back();
+        if (prev.rect.y == y0 && prev.rect.x + prev.rect.w == x0 &&
+            prev.mul == region.mul && prev.add[0] == region.add[0] &&
+            prev.add[1] == region.add[1] && prev.add[2] == region.add[2]) {
+          prev.rect.w += x1 - x0;
+          continue;
+        }
+      }
+      m_Regions.push_back(region);
+    }
+  }
+}
+
+void PostProcess::Apply(const PostEffects &fx, Uint32 *pixels, int w, int h,
+                        int outW, int outH, Uint32 frame) {
+  BuildRegions(fx, w, h, outW, outH);
+  // Scanlines darken odd rows after everything else
+  int keep = 256 - (fx.scanlines * 256 + 127) / 255;
+
+  // Regions are in row bands; walk each band row by row so the pass
+  // streams through memory once
+  size_t band = 0;
+  int y = 0;
+  while (y < h) {
+    int bandEnd = h;
+    size_t next = band;
+    while (next < m_Regions.size() && m_Regions[next].rect.y == y)
+      next++;
+    if (next < m_Regions.size())
+      bandEnd = m_Regions[next].rect.y;
+    if (next > band)
+      bandEnd = m_Regions[band].rect.y + m_Regions[band].rect.h;
+    else if (!fx.scanlines && !fx.grain) {
+      y = bandEnd; // Nothing to do on these rows
+      continue;
+    }
+
+    for (; y < bandEnd; y++) {
+      Uint32 *row = pixels + (size_t)y * w;
+      bool odd = fx.scanlines && (y & 1);
+      int identity[3] = {128, 128, 128};
+      if (!fx.grain) {
+        if (odd) {
+          // Rows untouched by any region still get the scanline
+          int x = 0;
+          for (size_t r = band; r < next; r++) {
+            const Region &reg = m_Regions[r];
+            BlendRow(row + x, reg.rect.x - x, keep, identity);
+            int add[3];
+            for (int c = 0; c < 3; c++)
+              add[c] = ((reg.add[c] - 128) * keep >> 8) + 128;
+            BlendRow(row + reg.rect.x, reg.rect.w, reg.mul * keep >> 8, add);
+            x = reg.rect.x + reg.rect.w;
+          }
+          BlendRow(row + x, w - x, keep, identity);
+        } else {
+          for (size_t r = band; r < next; r++) {
+            const Region &reg = m_Regions[r];
+            BlendRow(row + reg.rect.x, reg.rect.w, reg.mul, reg.add);
+          }
+        }
+        continue;
+      }
+
+      // Grain varies per pixel, so these rows take the scalar loop
+      size_t r = band;
+      for (int x = 0; x < w; x++) {
+        while (r < next &&
+               x >= m_Regions[r].rect.x + m_Regions[r].rect.w)
+          r++;
+        Uint32 c = row[x];
+        if (r < next && x >= m_Regions[r].rect.x)
+          c = BlendPixel(c, m_Regions[r].mul, m_Regions[r].add);
+        if (odd)
+          c = BlendPixel(c, keep, identity);
+        Uint32 hash = (Uint32)x * 73856093u ^ (Uint32)y * 19349663u ^
+                      frame * 83492791u;
+        hash ^= hash >> 13;
+        hash *= 0x5bd1e995u;
+        int noise = ((int)((hash >> 16) & 0xFF) - 128) * fx.grain >> 7;
+        int red = Clamp255((int)((c >> 16) & 0xFF) + noise);
+        int green = Clamp255((int)((c >> 8) & 0xFF) + noise);
+        int blue = Clamp255((int)(c & 0xFF) + noise);
+        row[x] = 0xFF000000u | ((Uint32)red << 16) | ((Uint32)green << 8) |
+                 (Uint32)blue;
+      }
+    }
+    band = next;
+  }
+}
+
+void PostProcess::Draw(SDL_Renderer *ren, const PostEffects &fx, int w,
+                       int h) {
+  BuildRegions(fx, w, h, w, h);
+  // c * mul + add is a plain alpha blend: alpha = 1 - mul, colour = add /
+  // alpha
+  SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+  for (const Region &region : m_Regions) {
+    float alpha = 1.0f - region.mul / 256.0f;
+    if (alpha <= 0.0f)
+      continue;
+    Uint8 rgb[3];
+    for (int c = 0; c < 3; c++)
+      rgb[c] = (Uint8)std::min(
+          255.0f, std::max(0.0f, (region.add[c] - 128) / 256.0f / alpha));
+    SDL_SetRenderDrawColor(ren, rgb[0], rgb[1], rgb[2],
+                           (Uint8)std::lround(alpha * 255.0f));
+    SDL_RenderFillRect(ren, &region.rect);
+  }
+  if (fx.scanlines) {
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, fx.scanlines);
+    std::vector<SDL_Rect> rows;
+    for (int y = 1; y < h; y += 2)
+      rows.push_back({0, y, w, 1});
+    SDL_RenderFillRects(ren, rows.data(), (int)rows.size());
+  }
+  SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+}
+
+void BlendRowScalar(Uint32 *pixels, int count, int mul, const int add[3]) {
+  for (int x = 0; x < count; x++)
+    pixels[x] = BlendPixel(pixels[x], mul, add);
+}
+
+#if defined(__AVX2__)
+
+void BlendRow(Uint32 *pixels, int count, int mul, const int add[3]) {
+  // Pixels widen to 16 bits per channel (B, G, R, A); alpha is forced to
+  // 255 through its add term
+  const __m256i mulv = _mm256_setr_epi16(mul, mul, mul, 0, mul, mul, mul, 0,
+                                         mul, mul, mul, 0, mul, mul, mul, 0);
+  const __m256i addv = _mm256_setr_epi16(
+      add[2], add[1], add[0], -256, add[2], add[1], add[0], -256, add[2],
+      add[1], add[0], -256, add[2], add[1], add[0], -256);
+  const __m256i zero = _mm256_setzero_si256();
+  int x = 0;
+  for (; x + 8 <= count; x += 8) {
+    __m256i c = _mm256_loadu_si256((const __m256i *)(pixels + x));
+    __m256i lo = _mm256_unpacklo_epi8(c, zero);
+    __m256i hi = _mm256_unpackhi_epi8(c, zero);
+    lo = _mm256_srli_epi16(
+        _mm256_adds_epu16(_mm256_mullo_epi16(lo, mulv), addv), 8);
+    hi = _mm256_srli_epi16(
+        _mm256_adds_epu16(_mm256_mullo_epi16(hi, mulv), addv), 8);
+    _mm256_storeu_si256((__m256i *)(pixels + x), _mm256_packus_epi16(lo, hi));
+  }
+  BlendRowScalar(pixels + x, count - x, mul, add);
+}
+
+#elif defined(__SSE2__)
+
+void BlendRow(Uint32 *pixels, int count, int mul, const int add[3]) {
+  const __m128i mulv = _mm_setr_epi16(mul, mul, mul, 0, mul, mul, mul, 0);
+  const __m128i addv = _mm_setr_epi16(add[2], add[1], add[0], -256, add[2],
+                                      add[1], add[0], -256);
+  const __m128i zero = _mm_setzero_si128();
+  int x = 0;
+  for (; x + 4 <= count; x += 4) {
+    __m128i c = _mm_loadu_si128((const __m128i *)(pixels + x));
+    __m128i lo = _mm_unpacklo_epi8(c, zero);
+    __m128i hi = _mm_unpackhi_epi8(c, zero);
+    lo = _mm_srli_epi16(_mm_adds_epu16(_mm_mullo_epi16(lo, mulv), addv), 8);
+    hi = _mm_srli_epi16(_mm_adds_epu16(_mm_mullo_epi16(hi, mulv), addv), 8);
+    _mm_storeu_si128((__m128i *)(pixels + x), _mm_packus_epi16(lo, hi));
+  }
+  BlendRowScalar(pixels + x, count - x, mul, add);
+}
+
+#else
+
+void BlendRow(Uint32 *pixels, int count, int mul, const int add[3]) {
+  BlendRowScalar(pixels, count, mul, add);
+}
+
+#endif
+
+} // namespace PixelsEngine
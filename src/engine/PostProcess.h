@@ -0,0 +1,62 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+
+namespace PixelsEngine {
+
+// Full-frame effects applied once the 3D view is drawn. Colours blend over
+// the frame with their alpha; alpha 0 turns an effect off.
+struct PostEffects {
+  bool vignette = true; // Darkened sides and top/bottom edges
+  // Solid rectangle over the vignette and under everything else (e.g. the
+  // grapple rope), in output pixels; an empty rectangle turns it off
+  SDL_Rect overlay = {0, 0, 0, 0};
+  SDL_Color overlayColor = {0, 0, 0, 255};
+  SDL_Color tint = {0, 0, 0, 0};  // Whole frame (e.g. slow motion)
+  SDL_Color focus = {0, 0, 0, 0}; // Centre half of the frame, over the tint
+  SDL_Color flash = {0, 0, 0, 0}; // Whole frame, over everything else
+  // Film effects
+  Uint8 scanlines = 0; // Darkening of every other row
+  Uint8 grain = 0;     // Per-pixel noise amplitude (software backend only)
+};
+
+// Every effect is a blend towards a colour over some rectangle, so the
+// effects that overlap a region fold into a single multiply-add per
+// channel. The frame is cut into the disjoint regions where that blend is
+// constant and each pixel is read and written once, instead of once per
+// stacked full-screen fill.
+class PostProcess {
+public:
+  // Software backend: applies the effects to w x h ARGB8888 pixels that
+  // are presented at outW x outH (vignette sizes are in output pixels).
+  // `frame` seeds the grain.
+  void Apply(const PostEffects &fx, Uint32 *pixels, int w, int h, int outW,
+             int outH, Uint32 frame);
+
+  // SDL_Renderer path: one blended fill per region at the current target's
+  // w x h
+  void Draw(SDL_Renderer *ren, const PostEffects &fx, int w, int h);
+
+  // Regions the last Apply/Draw used (rectangles that change any pixel)
+  int GetRegionCount() const { return (int)m_Regions.size(); }
+
+private:
+  // c' = min(65535, c * mul + add[ch]) >> 8; add includes the rounding
+  struct Region {
+    SDL_Rect rect;
+    int mul;
+    int add[3]; // R, G, B
+  };
+
+  void BuildRegions(const PostEffects &fx, int w, int h, int outW, int outH);
+
+  std::vector<Region> m_Regions;
+};
+
+// One row segment of the fused pass. Uses AVX2 (8 pixels per iteration) or
+// SSE2 (4) when the build targets them; the scalar path produces identical
+// output.
+void BlendRow(Uint32 *pixels, int count, int mul, const int add[3]);
+void BlendRowScalar(Uint32 *pixels, int count, int mul, const int add[3]);
+
+} // namespace PixelsEngine
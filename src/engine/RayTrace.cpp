@@ -0,0 +1,429 @@
+#include "RayTrace.h"
+#include <cmath>
+#include <cstdlib>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace PixelsEngine {
+
+namespace {
+
+struct RayState {
+  double sideDistX, sideDistY;
+  double deltaDistX, deltaDistY;
+  int stepX, stepY;
+  int mapX, mapY;
+  int side;
+  int steps;
+};
+
+RayState BeginRay(double posX, double posY, double rayDirX, double rayDirY) {
+  RayState s;
+  s.mapX = int(posX);
+  s.mapY = int(posY);
+  s.deltaDistX = (rayDirX == 0) ? 1e30 : std::abs(1 / rayDirX);
+  s.deltaDistY = (rayDirY == 0) ? 1e30 : std::abs(1 / rayDirY);
+  s.side = 0;
+  s.steps = 0;
+  if (rayDirX < 0) {
+    s.stepX = -1;
+    s.sideDistX = (posX - s.mapX) * s.deltaDistX;
+  } else {
+    s.stepX = 1;
+    s.sideDistX = (s.mapX + 1.0 - posX) * s.deltaDistX;
+  }
+  if (rayDirY < 0) {
+    s.stepY = -1;
+    s.sideDistY = (posY - s.mapY) * s.deltaDistY;
+  } else {
+    s.stepY = 1;
+    s.sideDistY = (s.mapY + 1.0 - posY) * s.deltaDistY;
+  }
+  return s;
+}
+
+RayHit HitFromState(const RayState &s) {
+  double dist = (s.side == 0) ? (s.sideDistX - s.deltaDistX)
+                              : (s.sideDistY - s.deltaDistY);
+  return {dist, s.side, s.mapX, s.mapY, s.steps};
+}
+
+// Steps until a solid cell is entered. Also used to finish packet lanes.
+RayHit FinishRay(const RayTracer &tracer, RayState s) {
+  bool hit = false;
+  while (!hit) {
+    if (s.sideDistX < s.sideDistY) {
+      s.sideDistX += s.deltaDistX;
+      s.mapX += s.stepX;
+      s.side = 0;
+    } else {
+      s.sideDistY += s.deltaDistY;
+      s.mapY += s.stepY;
+      s.side = 1;
+    }
+    s.steps++;
+    hit = tracer.IsSolid(s.mapX, s.mapY);
+  }
+  return HitFromState(s);
+}
+
+// Crossings of one axis, at sideDist + i * deltaDist, that happen before
+// time `limit`, capped at `maxCount`. invDelta is |rayDir| (1 / deltaDist).
+inline int CrossingsBefore(double sideDist, double invDelta, double limit,
+                           int maxCount) {
+  if (limit <= sideDist)
+    return 0;
+  double q = (limit - sideDist) * invDelta;
+  if (q >= maxCount)
+    return maxCount;
+  int n = (int)q;
+  return n < q ? n + 1 : n;
+}
+
+} // namespace
+
+void RayTracer::Build(const Map &map) {
+  if (m_Map == &map && m_MapRevision == map.GetRevision())
+    return;
+  m_Map = &map;
+  m_MapRevision = map.GetRevision();
+  for (int y = -1; y <= Map::HEIGHT; y++) {
+    for (int x = -1; x <= Map::WIDTH; x++) {
+      m_Solid[(y + 1) * STRIDE + (x + 1)] = map.BlocksRay(x, y) ? -1 : 0;
+      m_WallDistance[(y + 1) * STRIDE + (x + 1)] =
+          (Uint8)map.GetWallDistance(x, y);
+    }
+  }
+}
+
+RayHit RayTracer::Trace(double posX, double posY, double dirX,
+                        double dirY) const {
+  return FinishRay(*this, BeginRay(posX, posY, dirX, dirY));
+}
+
+RayHit RayTracer::TraceSkipping(double posX, double posY, double dirX,
+                                double dirY) const {
+  // The distance grid is read without clamping below, which needs the ray
+  // to start inside the map (walls then include the border)
+  if (!(posX >= 0 && posY >= 0 && posX < Map::WIDTH && posY < Map::HEIGHT))
+    return Trace(posX, posY, dirX, dirY);
+
+  RayState s = BeginRay(posX, posY, dirX, dirY);
+  double invDeltaX = std::abs(dirX);
+  double invDeltaY = std::abs(dirY);
+  const Uint8 *distance = m_WallDistance.data();
+  int d = distance[(s.mapY + 1) * STRIDE + s.mapX + 1];
+  for (;;) {
+    // The square of cells within `radius` of this one is empty, so take
+    // every crossing before the ray leaves it in one go. Walls are only
+    // ever entered by the ordinary step below. A radius of 1 saves at most
+    // one step and is not worth the arithmetic.
+    int radius = d - 1;
+    if (radius > 1) {
+      double exit = std::min(s.sideDistX + radius * s.deltaDistX,
+                             s.sideDistY + radius * s.deltaDistY);
+      int nX = CrossingsBefore(s.sideDistX, invDeltaX, exit, radius);
+      int nY = CrossingsBefore(s.sideDistY, invDeltaY, exit, radius);
+      if (nX + nY > 1) {
+        s.sideDistX += nX * s.deltaDistX;
+        s.sideDistY += nY * s.deltaDistY;
+        s.mapX += nX * s.stepX;
+        s.mapY += nY * s.stepY;
+        s.steps++;
+      }
+    }
+    if (s.sideDistX < s.sideDistY) {
+      s.sideDistX += s.deltaDistX;
+      s.mapX += s.stepX;
+      s.side = 0;
+    } else {
+      s.sideDistY += s.deltaDistY;
+      s.mapY += s.stepY;
+      s.side = 1;
+    }
+    s.steps++;
+    // Distance 0 marks a wall, so one load answers both questions
+    d = distance[(s.mapY + 1) * STRIDE + s.mapX + 1];
+    if (d == 0)
+      return HitFromState(s);
+  }
+}
+
+#if defined(__AVX2__) || defined(__SSE2__)
+
+namespace {
+
+// Lanes are doubles so packet hits match the scalar loop bit for bit. Cell
+// indices ride alongside as 64-bit integers, and the solid grid stores
+// all-ones for walls, so a lookup is usable as a lane mask without any
+// conversion on the critical path.
+#if defined(__AVX2__)
+
+struct Lanes {
+  using V = __m256d;
+  using VI = __m256i;
+  static const int N = 4;
+  static V Load(const double *p) { return _mm256_loadu_pd(p); }
+  static void Store(double *p, V v) { _mm256_storeu_pd(p, v); }
+  static void StoreI(Sint64 *p, VI v) { _mm256_storeu_si256((VI *)p, v); }
+  static V Add(V a, V b) { return _mm256_add_pd(a, b); }
+  static V Sub(V a, V b) { return _mm256_sub_pd(a, b); }
+  static V Div(V a, V b) { return _mm256_div_pd(a, b); }
+  static V Mul(V a, V b) { return _mm256_mul_pd(a, b); }
+  static V And(V a, V b) { return _mm256_and_pd(a, b); }
+  static V AndNot(V a, V b) { return _mm256_andnot_pd(a, b); }
+  static V Or(V a, V b) { return _mm256_or_pd(a, b); }
+  static V Less(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_LT_OQ); }
+  static V Equal(V a, V b) { return _mm256_cmp_pd(a, b, _CMP_EQ_OQ); }
+  static V Select(V mask, V a, V b) { return _mm256_blendv_pd(b, a, mask); }
+  static V Set1(double d) { return _mm256_set1_pd(d); }
+  static VI Set1I(Sint64 i) { return _mm256_set1_epi64x(i); }
+  static int MoveMask(V v) { return _mm256_movemask_pd(v); }
+
+  // a + (mask ? b : 0) on the integer lanes
+  static VI AddMasked(VI a, VI b, V mask) {
+    return _mm256_add_epi64(a, _mm256_and_si256(b, _mm256_castpd_si256(mask)));
+  }
+  static VI SelectI(V mask, VI a, VI b) {
+    return _mm256_castpd_si256(_mm256_blendv_pd(
+        _mm256_castsi256_pd(b), _mm256_castsi256_pd(a), mask));
+  }
+
+  // Hardware gathers are slower than four plain loads on many cores
+  static V SolidMask(const Sint64 *grid, VI index) {
+    __m128i lo = _mm256_castsi256_si128(index);
+    __m128i hi = _mm256_extracti128_si256(index, 1);
+    return _mm256_castsi256_pd(_mm256_set_epi64x(
+        grid[_mm_extract_epi64(hi, 1)], grid[_mm_cvtsi128_si64(hi)],
+        grid[_mm_extract_epi64(lo, 1)], grid[_mm_cvtsi128_si64(lo)]));
+  }
+};
+
+#else
+
+struct Lanes {
+  using V = __m128d;
+  using VI = __m128i;
+  static const int N = 2;
+  static V Load(const double *p) { return _mm_loadu_pd(p); }
+  static void Store(double *p, V v) { _mm_storeu_pd(p, v); }
+  static void StoreI(Sint64 *p, VI v) { _mm_storeu_si128((VI *)p, v); }
+  static V Add(V a, V b) { return _mm_add_pd(a, b); }
+  static V Sub(V a, V b) { return _mm_sub_pd(a, b); }
+  static V Div(V a, V b) { return _mm_div_pd(a, b); }
+  static V Mul(V a, V b) { return _mm_mul_pd(a, b); }
+  static V And(V a, V b) { return _mm_and_pd(a, b); }
+  static V AndNot(V a, V b) { return _mm_andnot_pd(a, b); }
+  static V Or(V a, V b) { return _mm_or_pd(a, b); }
+  static V Less(V a, V b) { return _mm_cmplt_pd(a, b); }
+  static V Equal(V a, V b) { return _mm_cmpeq_pd(a, b); }
+  static V Select(V mask, V a, V b) {
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+  }
+  static V Set1(double d) { return _mm_set1_pd(d); }
+  static VI Set1I(Sint64 i) { return _mm_set1_epi64x(i); }
+  static int MoveMask(V v) { return _mm_movemask_pd(v); }
+
+  static VI AddMasked(VI a, VI b, V mask) {
+    return _mm_add_epi64(a, _mm_and_si128(b, _mm_castpd_si128(mask)));
+  }
+  static VI SelectI(V mask, VI a, VI b) {
+    __m128i m = _mm_castpd_si128(mask);
+    return _mm_or_si128(_mm_and_si128(m, a), _mm_andnot_si128(m, b));
+  }
+
+  static V SolidMask(const Sint64 *grid, VI index) {
+    Sint64 lo = grid[_mm_cvtsi128_si64(index)];
+    Sint64 hi = grid[_mm_cvtsi128_si64(_mm_unpackhi_epi64(index, index))];
+    return _mm_castsi128_pd(_mm_set_epi64x(hi, lo));
+  }
+};
+
+#endif
+
+using V = Lanes::V;
+using VI = Lanes::VI;
+
+// One register's worth of rays. A packet is two groups so their dependency
+// chains (compare, step, lookup) overlap.
+struct LaneGroup {
+  V sideDistX, sideDistY;
+  V deltaX, deltaY;
+  VI stepX, stepY; // Grid index offsets: +-1 and +-stride
+  VI index;        // Cell index in the padded grid
+  V side;
+  V active;
+};
+
+const int PACKET = 2 * Lanes::N;
+
+struct PacketOrigin {
+  V zero, one, signBit, far;
+  V posX, posY;
+  V cellX0, cellY0, cellX1, cellY1;
+  VI index;
+  VI stride; // Grid index offset of one row
+};
+
+// Same setup as BeginRay for Lanes::N rays
+inline LaneGroup BeginGroup(const PacketOrigin &o, const double *dirX,
+                            const double *dirY) {
+  LaneGroup g;
+  V rx = Lanes::Load(dirX);
+  V ry = Lanes::Load(dirY);
+  g.deltaX = Lanes::Select(Lanes::Equal(rx, o.zero), o.far,
+                           Lanes::AndNot(o.signBit, Lanes::Div(o.one, rx)));
+  g.deltaY = Lanes::Select(Lanes::Equal(ry, o.zero), o.far,
+                           Lanes::AndNot(o.signBit, Lanes::Div(o.one, ry)));
+  V negX = Lanes::Less(rx, o.zero);
+  V negY = Lanes::Less(ry, o.zero);
+  g.sideDistX = Lanes::Mul(Lanes::Select(negX, Lanes::Sub(o.posX, o.cellX0),
+                                         Lanes::Sub(o.cellX1, o.posX)),
+                           g.deltaX);
+  g.sideDistY = Lanes::Mul(Lanes::Select(negY, Lanes::Sub(o.posY, o.cellY0),
+                                         Lanes::Sub(o.cellY1, o.posY)),
+                           g.deltaY);
+  g.stepX = Lanes::SelectI(negX, Lanes::Set1I(-1), Lanes::Set1I(1));
+  g.stepY = Lanes::SelectI(negY, Lanes::Set1I(-(Map::WIDTH + 2)), o.stride);
+  g.index = o.index;
+  g.side = o.zero;
+  g.active = Lanes::Equal(o.zero, o.zero);
+  return g;
+}
+
+// One DDA step on every live lane. Returns the mask of lanes still live.
+inline int StepGroup(LaneGroup &g, const Sint64 *grid, V one) {
+  // Same choice as the scalar loop, applied only to live lanes
+  V xFirst = Lanes::Less(g.sideDistX, g.sideDistY);
+  V moveX = Lanes::And(xFirst, g.active);
+  V moveY = Lanes::AndNot(xFirst, g.active);
+  g.sideDistX = Lanes::Add(g.sideDistX, Lanes::And(g.deltaX, moveX));
+  g.sideDistY = Lanes::Add(g.sideDistY, Lanes::And(g.deltaY, moveY));
+  g.index = Lanes::AddMasked(Lanes::AddMasked(g.index, g.stepX, moveX),
+                             g.stepY, moveY);
+  g.side = Lanes::Or(Lanes::AndNot(g.active, g.side), Lanes::And(one, moveY));
+  g.active = Lanes::AndNot(Lanes::SolidMask(grid, g.index), g.active);
+  return Lanes::MoveMask(g.active);
+}
+
+inline int PopCount(int mask) {
+  int n = 0;
+  for (; mask; mask &= mask - 1)
+    n++;
+  return n;
+}
+
+// Writes the hits of one group; lanes still live finish as single rays
+void FinishGroup(const RayTracer &tracer, const LaneGroup &g, int startX,
+                 int startY, const double *dirX, const double *dirY,
+                 RayHit *out) {
+  const int stride = Map::WIDTH + 2;
+  double sdx[Lanes::N], sdy[Lanes::N], ddx[Lanes::N], ddy[Lanes::N];
+  double sd[Lanes::N];
+  Sint64 idx[Lanes::N];
+  Lanes::Store(sdx, g.sideDistX);
+  Lanes::Store(sdy, g.sideDistY);
+  Lanes::Store(ddx, g.deltaX);
+  Lanes::Store(ddy, g.deltaY);
+  Lanes::Store(sd, g.side);
+  Lanes::StoreI(idx, g.index);
+  int liveMask = Lanes::MoveMask(g.active);
+  for (int l = 0; l < Lanes::N; l++) {
+    int cell = (int)idx[l];
+    RayState s;
+    s.sideDistX = sdx[l];
+    s.sideDistY = sdy[l];
+    s.deltaDistX = ddx[l];
+    s.deltaDistY = ddy[l];
+    s.mapX = cell % stride - 1;
+    s.mapY = cell / stride - 1;
+    s.side = (int)sd[l];
+    // Every DDA step moves one cell along one axis
+    s.steps = std::abs(s.mapX - startX) + std::abs(s.mapY - startY);
+    if (liveMask & (1 << l)) {
+      s.stepX = dirX[l] < 0 ? -1 : 1;
+      s.stepY = dirY[l] < 0 ? -1 : 1;
+      out[l] = FinishRay(tracer, s);
+    } else {
+      out[l] = HitFromState(s);
+    }
+  }
+}
+
+} // namespace
+
+int RayTracer::GetPacketWidth() { return PACKET; }
+
+#if defined(__AVX2__)
+const char *RayTracer::GetKernelName() { return "AVX2 x8"; }
+#else
+const char *RayTracer::GetKernelName() { return "SSE2 x4"; }
+#endif
+
+void RayTracer::TracePacket(double posX, double posY, const double *dirX,
+                            const double *dirY, int count,
+                            RayHit *out) const {
+  int mapX = int(posX);
+  int mapY = int(posY);
+  bool inside = posX >= 0 && posY >= 0 && mapX < Map::WIDTH &&
+                mapY < Map::HEIGHT;
+  int i = 0;
+  // Packet lanes index the padded grid without bounds checks, which only
+  // holds while every ray starts inside the map
+  if (inside) {
+    const Sint64 *grid = m_Solid.data();
+    PacketOrigin o;
+    o.zero = Lanes::Set1(0.0);
+    o.one = Lanes::Set1(1.0);
+    o.signBit = Lanes::Set1(-0.0);
+    o.far = Lanes::Set1(1e30);
+    o.posX = Lanes::Set1(posX);
+    o.posY = Lanes::Set1(posY);
+    o.cellX0 = Lanes::Set1((double)mapX);
+    o.cellY0 = Lanes::Set1((double)mapY);
+    o.cellX1 = Lanes::Set1(mapX + 1.0);
+    o.cellY1 = Lanes::Set1(mapY + 1.0);
+    o.index = Lanes::Set1I((mapY + 1) * STRIDE + mapX + 1);
+    o.stride = Lanes::Set1I(STRIDE);
+    // Below this many live lanes the packet is mostly idle
+    const int minLanes = PACKET / 4 + 1;
+
+    for (; i + PACKET <= count; i += PACKET) {
+      const int n = Lanes::N;
+      LaneGroup a = BeginGroup(o, dirX + i, dirY + i);
+      LaneGroup b = BeginGroup(o, dirX + i + n, dirY + i + n);
+      int live;
+      do {
+        int maskA = StepGroup(a, grid, o.one);
+        int maskB = StepGroup(b, grid, o.one);
+        live = PopCount(maskA | (maskB << n));
+      } while (live >= minLanes);
+      FinishGroup(*this, a, mapX, mapY, dirX + i, dirY + i, out + i);
+      FinishGroup(*this, b, mapX, mapY, dirX + i + n, dirY + i + n,
+                  out + i + n);
+    }
+  }
+  for (; i < count; i++)
+    out[i] = Trace(posX, posY, dirX[i], dirY[i]);
+}
+
+#else
+
+int RayTracer::GetPacketWidth() { return 1; }
+
+const char *RayTracer::GetKernelName() { return "Scalar"; }
+
+void RayTracer::TracePacket(double posX, double posY, const double *dirX,
+                            const double *dirY, int count,
+                            RayHit *out) const {
+  for (int i = 0; i < count; i++)
+    out[i] = Trace(posX, posY, dirX[i], dirY[i]);
+}
+
+#endif
+
+} // namespace PixelsEngine
@@ -0,0 +1,63 @@
+#pragma once
+#include "Map.h"
+#include <SDL2/SDL.h>
+#include <vector>
+
+namespace PixelsEngine {
+
+struct RayHit {
+  double dist; // Perpendicular distance to the wall
+  int side;    // 0 = X side, 1 = Y side
+  int mapX;
+  int mapY;
+  int steps; // DDA iterations it took (a distance-field jump counts as one)
+};
+
+// Grid DDA against a snapshot of which map cells block rays. Trace() walks a
+// single ray; TracePacket() advances GetPacketWidth() rays in lockstep with
+// SIMD (8 with AVX2, 4 with SSE2, 1 without) and hands the last few lanes
+// back to the scalar loop once most of the packet has hit. Both return
+// identical hits. TraceSkipping() uses the map's wall distance field to jump
+// across empty space; it hits the same cells, with distances that can differ
+// in the last few bits.
+class RayTracer {
+public:
+  // Copies the map's blocks-ray plane and wall distances. Cheap to call
+  // every frame: nothing is done unless the map or its revision changed.
+  void Build(const Map &map);
+
+  RayHit Trace(double posX, double posY, double dirX, double dirY) const;
+  RayHit TraceSkipping(double posX, double posY, double dirX,
+                       double dirY) const;
+
+  // Traces `count` rays that share an origin. Any count is accepted; the
+  // tail that does not fill a packet is traced one ray at a time.
+  void TracePacket(double posX, double posY, const double *dirX,
+                   const double *dirY, int count, RayHit *out) const;
+
+  bool IsSolid(int x, int y) const {
+    if ((unsigned)(x + 1) >= (unsigned)STRIDE ||
+        (unsigned)(y + 1) >= (unsigned)(Map::HEIGHT + 2))
+      return true;
+    return m_Solid[(y + 1) * STRIDE + (x + 1)] != 0;
+  }
+
+  static int GetPacketWidth();
+  static const char *GetKernelName();
+
+private:
+  // One cell of solid border so packet lanes never need a bounds check
+  static const int STRIDE = Map::WIDTH + 2;
+
+  // -1 (all bits set) for cells that stop a ray, so SIMD lanes can use a
+  // cell directly as a mask
+  std::vector<Sint64> m_Solid =
+      std::vector<Sint64>(STRIDE * (Map::HEIGHT + 2), -1);
+  // Map::GetWallDistance on the same padded grid (0 = wall)
+  std::vector<Uint8> m_WallDistance =
+      std::vector<Uint8>(STRIDE * (Map::HEIGHT + 2), 0);
+  const Map *m_Map = nullptr;
+  unsigned m_MapRevision = 0;
+};
+
+} // namespace PixelsEngine
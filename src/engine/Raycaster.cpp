@@ -1,15 +1,149 @@
 #include "Raycaster.h"
 #include "Components.h"
+#include "FloorKernel.h"
 #include "TextureManager.h"
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <cstring>
 #include <iostream>
 
 namespace PixelsEngine {
 
-Raycaster::Raycaster() : m_ScreenWidth(0), m_ScreenHeight(0) {}
+namespace {
 
-Raycaster::~Raycaster() {}
+// Colour modulation for a wall column: side shading plus distance fog
+SDL_Color WallShade(const Shading &shading, const Material &mat, int side,
+                    double dist) {
+  return shading.Wall(dist, side == 1 && (mat.flags & MAT_SIDE_SHADE),
+                      (mat.flags & MAT_FOG) != 0);
+}
+
+// Smallest mip level that still has a row for every screen pixel of a wall
+// lineHeight pixels tall, so a coarser level is never stretched
+const AtlasRegion &WallMip(const Material &mat, int lineHeight) {
+  int level = 0;
+  while (level + 1 < mat.wallMipCount &&
+         mat.wallMips[level + 1].rect.h >= lineHeight)
+    level++;
+  return mat.wallMips[level];
+}
+
+inline Uint32 PackRGB(int r, int g, int b) {
+  return 0xFF000000u | ((Uint32)r << 16) | ((Uint32)g << 8) | (Uint32)b;
+}
+
+// Alpha-blend a texel (with colour modulation) over an opaque destination
+inline Uint32 BlendTexel(Uint32 dst, Uint32 src, int modR, int modG,
+                         int modB) {
+  int a = src >> 24;
+  int r = ((src >> 16) & 0xFF) * modR / 255;
+  int g = ((src >> 8) & 0xFF) * modG / 255;
+  int b = (src & 0xFF) * modB / 255;
+  if (a == 255)
+    return PackRGB(r, g, b);
+  int dr = (dst >> 16) & 0xFF;
+  int dg = (dst >> 8) & 0xFF;
+  int db = dst & 0xFF;
+  return PackRGB(dr + (r - dr) * a / 255, dg + (g - dg) * a / 255,
+                 db + (b - db) * a / 255);
+}
+
+// `count` rows of one billboard column, stepping the texel row by
+// whole + frac / spriteH per screen row. Modulate = false is only used when
+// the modulation is 255,255,255, which BlendTexel leaves unchanged.
+template <bool Modulate>
+inline void DrawBillboardRows(Uint32 *dst, int pitch, const Uint32 *column,
+                              int texW, int texY, int rem, int whole, int frac,
+                              int spriteH, int count, int modR, int modG,
+                              int modB) {
+  for (int i = 0; i < count; i++, dst += pitch) {
+    Uint32 src = column[texY * texW];
+    if (Modulate)
+      *dst = BlendTexel(*dst, src, modR, modG, modB);
+    else if ((src >> 24) == 255)
+      *dst = src;
+    else
+      *dst = BlendTexel(*dst, src, 255, 255, 255);
+    texY += whole;
+    rem += frac;
+    if (rem >= spriteH) {
+      rem -= spriteH;
+      texY++;
+    }
+  }
+}
+
+// Calls fn(begin, end) for each run of columns in [x0, x1) where something at
+// `depth` is in front of the walls
+template <typename Fn>
+void ForEachVisibleRun(const std::vector<double> &zBuffer, int x0, int x1,
+                       double depth, Fn fn) {
+  int x = x0;
+  while (x < x1) {
+    while (x < x1 && depth >= zBuffer[x])
+      x++;
+    int begin = x;
+    while (x < x1 && depth < zBuffer[x])
+      x++;
+    if (x > begin)
+      fn(begin, x);
+  }
+}
+
+// Same, for a projected sprite. Sprites in front of every wall they cover
+// are one run with no per-column tests.
+template <typename Sprite, typename Fn>
+void ForEachVisibleRun(const std::vector<double> &zBuffer, const Sprite &s,
+                       Fn fn) {
+  if (s.fullyVisible)
+    fn(s.clipStartX, s.clipEndX);
+  else
+    ForEachVisibleRun(zBuffer, s.clipStartX, s.clipEndX, s.depth, fn);
+}
+
+} // namespace
+
+Raycaster::Raycaster() : m_ScreenWidth(0), m_ScreenHeight(0) {
+  for (auto &ids : m_WallRegionIds)
+    ids.fill(-1);
+  m_FloorRegionIds.fill(-1);
+  for (auto &mat : m_Materials)
+    mat.flags = MAT_SIDE_SHADE | MAT_FOG;
+}
+
+Raycaster::~Raycaster() {
+  for (SDL_Texture *tex : m_FrameTextures) {
+    if (tex)
+      SDL_DestroyTexture(tex);
+  }
+  if (m_SceneTarget)
+    SDL_DestroyTexture(m_SceneTarget);
+  if (m_FloorTexture)
+    SDL_DestroyTexture(m_FloorTexture);
+}
+
+const char *Raycaster::GetRayTraversalName(RayTraversal traversal) {
+  switch (traversal) {
+  case RayTraversal::Scalar:
+    return "Scalar";
+  case RayTraversal::Packet:
+    return RayTracer::GetKernelName();
+  case RayTraversal::DistanceField:
+    return "Distance field";
+  }
+  return "Unknown";
+}
+
+const char *Raycaster::GetBackendName(RenderBackend backend) {
+  switch (backend) {
+  case RenderBackend::SDLRenderer:
+    return "SDL_Renderer";
+  case RenderBackend::Software:
+    return "Software";
+  }
+  return "Unknown";
+}
 
 void Raycaster::Init(SDL_Renderer *ren) {
   int w, h;
@@ -17,213 +151,543 @@ void Raycaster::Init(SDL_Renderer *ren) {
   m_ScreenWidth = w;
   m_ScreenHeight = h;
   m_ZBuffer.resize(w);
+  m_Renderer = ren;
+
+  // Solid white texels in the atlas let untextured quads (particles) go
+  // into the same geometry batches as billboards, tinted by vertex colour
+  const Uint32 white[4] = {0xFFFFFFFFu, 0xFFFFFFFFu, 0xFFFFFFFFu,
+                           0xFFFFFFFFu};
+  m_WhiteRegionId =
+      m_Atlas.Add(std::make_shared<Texture>(ren, 2, 2, white));
+}
+
+void Raycaster::LoadTexture(int id, const std::string &path, Uint8 flags) {
+  id &= MAX_MATERIALS - 1;
+  m_Materials[id].flags = flags;
+  auto texture = TextureManager::LoadTexture(m_Renderer, path);
+  std::array<int, MAX_WALL_MIPS> &ids = m_WallRegionIds[id];
+  ids.fill(-1);
+  ids[0] = m_Atlas.Add(texture);
+  // Tiles sharing an image share its mip chain too
+  for (const auto &other : m_WallRegionIds) {
+    if (&other != &ids && other[0] == ids[0]) {
+      ids = other;
+      return;
+    }
+  }
+  for (int level = 1; level < MAX_WALL_MIPS; level++) {
+    if (!texture || texture->GetWidth() <= 1 || texture->GetHeight() <= 1)
+      break;
+    texture = texture->CreateHalfSize();
+    if (!texture)
+      break;
+    ids[level] = m_Atlas.Add(texture);
+  }
 }
 
-void Raycaster::LoadTexture(int id, const std::string &path) {}
+void Raycaster::LoadFloorTexture(int id, const std::string &path) {
+  id &= MAX_MATERIALS - 1;
+  m_FloorImages[id] = TextureManager::LoadTexture(m_Renderer, path);
+  m_FloorRegionIds[id] = m_Atlas.Add(m_FloorImages[id]);
+  m_FloorTexturesDirty = true;
+}
 
-void Raycaster::Render(SDL_Renderer *ren, const Camera &cam, const Map &map,
-                       Registry &reg, float roll) {
-  int w, h;
-  SDL_RenderGetLogicalSize(ren, &w, &h);
-  if (w == 0 || h == 0)
-    SDL_GetRendererOutputSize(ren, &w, &h);
+void Raycaster::LoadCeilingTexture(int id, const std::string &path) {
+  id &= MAX_MATERIALS - 1;
+  m_CeilingImages[id] = TextureManager::LoadTexture(m_Renderer, path);
+  m_FloorTexturesDirty = true;
+}
 
+void Raycaster::AddSpriteTexture(const std::shared_ptr<Texture> &texture) {
+  if (texture)
+    m_Atlas.Add(texture);
+}
+
+void Raycaster::UpdateAtlas(SDL_Renderer *ren) {
+  if (!m_Atlas.IsDirty())
+    return;
+  m_Atlas.Build(ren);
+  for (int id = 0; id < MAX_MATERIALS; id++) {
+    Material &mat = m_Materials[id];
+    mat.wallMipCount = 0;
+    for (int level = 0; level < MAX_WALL_MIPS; level++) {
+      int region = m_WallRegionIds[id][level];
+      mat.wallMips[level] =
+          region >= 0 ? m_Atlas.GetRegion(region) : AtlasRegion();
+      if (mat.wallMips[level].IsValid())
+        mat.wallMipCount = level + 1;
+    }
+    mat.wall = mat.wallMips[0];
+    mat.floor = m_FloorRegionIds[id] >= 0
+                    ? m_Atlas.GetRegion(m_FloorRegionIds[id])
+                    : AtlasRegion();
+  }
+  // Wall tiles without their own image borrow the default wall's
+  for (auto &mat : m_Materials) {
+    if (!mat.wall.IsValid()) {
+      mat.wall = m_Materials[1].wall;
+      mat.wallMips = m_Materials[1].wallMips;
+      mat.wallMipCount = m_Materials[1].wallMipCount;
+    }
+  }
+  for (int id = 0; id < MAX_MATERIALS; id++) {
+    const Material &mat = m_Materials[id];
+    WallMaterial &wall = m_WallMaterials[id];
+    wall = WallMaterial();
+    wall.flags = mat.flags;
+    for (int level = 0; level < mat.wallMipCount; level++) {
+      const AtlasRegion &region = mat.wallMips[level];
+      const Texture *page = m_Atlas.GetPage(region.page);
+      if (!page || !page->GetPixels())
+        break;
+      int pageW = page->GetWidth();
+      wall.mips[level] = {page->GetPixels() + region.rect.y * pageW +
+                              region.rect.x,
+                          pageW, region.rect.w, region.rect.h};
+      wall.mipCount = level + 1;
+    }
+  }
+}
+
+void Raycaster::UpdateFloorTextures() {
+  if (!m_FloorTexturesDirty)
+    return;
+  m_FloorTexturesDirty = false;
+  m_FloorTextures.Clear();
+  // Images used by several tiles (or as floor and ceiling) are stored once
+  std::unordered_map<const Texture *, int> added;
+  auto add = [&](const std::shared_ptr<Texture> &image) {
+    if (!image || !image->GetPixels())
+      return -1;
+    auto it = added.find(image.get());
+    if (it != added.end())
+      return it->second;
+    int index = m_FloorTextures.Add(image->GetPixels(), image->GetWidth(),
+                                    image->GetHeight());
+    added[image.get()] = index;
+    return index;
+  };
+  std::array<int, MAX_MATERIALS> floorIndex, ceilingIndex;
+  for (int id = 0; id < MAX_MATERIALS; id++) {
+    floorIndex[id] = add(m_FloorImages[id]);
+    ceilingIndex[id] = add(m_CeilingImages[id]);
+  }
+  // Resolve pointers only once the set has stopped growing
+  m_HasCeiling = false;
+  for (int id = 0; id < MAX_MATERIALS; id++) {
+    m_FloorTileTextures[id] =
+        floorIndex[id] >= 0 ? m_FloorTextures.Get(floorIndex[id]) : nullptr;
+    m_CeilingTileTextures[id] =
+        ceilingIndex[id] >= 0 ? m_FloorTextures.Get(ceilingIndex[id]) : nullptr;
+    m_HasCeiling |= ceilingIndex[id] >= 0;
+  }
+}
+
+void Raycaster::SetRenderScale(float scaleX, float scaleY) {
+  m_RenderScaleX = std::max(MIN_RENDER_SCALE, std::min(scaleX, 1.0f));
+  m_RenderScaleY = std::max(MIN_RENDER_SCALE, std::min(scaleY, 1.0f));
+}
+
+SDL_Texture *Raycaster::GetSceneTarget(SDL_Renderer *ren, int w, int h) {
+  if (m_SceneTarget && m_SceneTargetW == w && m_SceneTargetH == h)
+    return m_SceneTarget;
+  if (m_SceneTarget)
+    SDL_DestroyTexture(m_SceneTarget);
+  m_SceneTarget = nullptr;
+  m_SceneTargetW = m_SceneTargetH = 0;
+  if (!SDL_RenderTargetSupported(ren))
+    return nullptr;
+  // Created under Application's nearest-neighbour scale quality hint
+  m_SceneTarget = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888,
+                                    SDL_TEXTUREACCESS_TARGET, w, h);
+  if (!m_SceneTarget) {
+    std::cerr << "Failed to create scene render target! SDL_Error: "
+              << SDL_GetError() << std::endl;
+    return nullptr;
+  }
+  m_SceneTargetW = w;
+  m_SceneTargetH = h;
+  return m_SceneTarget;
+}
+
+void Raycaster::ViewSetup::Update(float newYaw, int newWidth) {
+  if (newYaw == yaw && newWidth == width)
+    return;
+  yaw = newYaw;
+  width = newWidth;
+  dirX = std::cos(yaw);
+  dirY = std::sin(yaw);
+  planeX = -0.66 * dirY;
+  planeY = 0.66 * dirX;
+  leftX = dirX - planeX;
+  leftY = dirY - planeY;
+  rightX = dirX + planeX;
+  rightY = dirY + planeY;
+  rayDirX.resize(width);
+  rayDirY.resize(width);
+  for (int x = 0; x < width; x++) {
+    double cameraX = 2 * x / (double)width - 1;
+    rayDirX[x] = dirX + planeX * cameraX;
+    rayDirY[x] = dirY + planeY * cameraX;
+  }
+}
+
+void Raycaster::Render(SDL_Renderer *ren, const Camera &outputCam,
+                       const Map &map, Registry &reg, float roll) {
+  int outW, outH;
+  SDL_RenderGetLogicalSize(ren, &outW, &outH);
+  if (outW == 0 || outH == 0)
+    SDL_GetRendererOutputSize(ren, &outW, &outH);
+  m_OutputWidth = outW;
+  m_OutputHeight = outH;
+
+  int w = std::max(1, (int)std::lround(outW * m_RenderScaleX));
+  int h = std::max(1, (int)std::lround(outH * m_RenderScaleY));
   if (w != m_ScreenWidth || h != m_ScreenHeight) {
     m_ScreenWidth = w;
     m_ScreenHeight = h;
     m_ZBuffer.resize(w);
   }
+  m_Stats.viewWidth = w;
+  m_Stats.viewHeight = h;
 
-  // 1. Procedural Parallax Sky (Daytime)
-  float skyOffset = (cam.yaw / (2.0f * M_PI)) * w * 2.0f;
-  for (int x = 0; x < w; x++) {
-    int pixelX = (x + (int)skyOffset) % w;
-    float grad = (float)pixelX / w;
+  // Pitch and roll are in output pixels; carry them over to the internal
+  // grid so a scaled view frames the same scene
+  float scaleX = (float)w / outW;
+  float scaleY = (float)h / outH;
+  Camera cam = outputCam;
+  cam.width = w;
+  cam.height = h;
+  cam.pitch *= scaleY;
+  roll *= scaleY / scaleX;
+  m_PixelAspect = (double)scaleX / scaleY;
 
-    // Sky Gradient (Cyan to Blue)
-    SDL_SetRenderDrawColor(ren, 135, 206, 235, 255); // Sky Blue
-    SDL_RenderDrawLine(ren, x, 0, x, h / 2 + (int)cam.pitch);
+  m_View.Update(cam.yaw, w);
+  UpdateAtlas(ren);
+  UpdateFloorTextures();
+  // Dynamic Ambient Pulse (Global light)
+  m_Shading.SetAmbient(0.95f + sin(SDL_GetTicks() * 0.002f) * 0.05f);
+  m_Sky.Build(ren, outW, outH);
 
-    // Simple Sun (Fixed direction)
-    float sunDir = 1.0f; // Approx angle
-    float angle = atan2(sin(cam.yaw), cos(cam.yaw)); // Current yaw -PI to PI
-    // Mapping is complex, simplified: just draw a fixed sun in skybox texture logic
-    // Or just a bright gradient at top
-    // Let's stick to gradient for now, maybe add a circle later if needed.
-    // Horizon glow (White)
-    SDL_SetRenderDrawColor(ren, 200, 220, 255, 255);
-    SDL_RenderDrawPoint(ren, x, h / 2 + (int)cam.pitch);
+  Uint64 startCounter = SDL_GetPerformanceCounter();
+  if (m_Backend == RenderBackend::Software) {
+    // The framebuffer is w x h; presenting stretches it to the output
+    RenderSoftware(cam, map, reg, roll);
+    PresentFramebuffer(ren);
+    m_Stats.renderMs = (SDL_GetPerformanceCounter() - startCounter) * 1000.0 /
+                       SDL_GetPerformanceFrequency();
+    return;
   }
 
-  // Dynamic Ambient Pulse (Global light)
-  float pulse = 0.95f + sin(SDL_GetTicks() * 0.002f) * 0.05f;
-
-  // Floor Gradient & Special Tiles
-  double dirX = std::cos(cam.yaw);
-  double dirY = std::sin(cam.yaw);
-  double planeX = -0.66 * dirY;
-  double planeY = 0.66 * dirX;
-
-  for (int y = h / 2 + (int)cam.pitch + 1; y < h; y++) {
-    float rowDist = (cam.z * h) / (y - h / 2 - (int)cam.pitch);
-    // Abyss depth (Ground is at -20.0, camera at cam.z)
-    float abyssDist = ((cam.z + 20.0f) * h) / (y - h / 2 - (int)cam.pitch);
-    
-    double rayDirX0 = dirX - planeX;
-    double rayDirY0 = dirY - planeY;
-    double rayDirX1 = dirX + planeX;
-    double rayDirY1 = dirY + planeY;
-
-    double floorStepX = rowDist * (rayDirX1 - rayDirX0) / w;
-    double floorStepY = rowDist * (rayDirY1 - rayDirY0) / w;
-    double floorX = cam.x + rowDist * rayDirX0;
-    double floorY = cam.y + rowDist * rayDirY0;
-
-    for (int x = 0; x < w; x++) {
-      int cellX = (int)(floorX);
-      int cellY = (int)(floorY);
-      int tile = map.Get(cellX, cellY);
-
-      if (tile == 4) {
-          // Abyss Rendering (Parallax)
-          // Calculate deep floor position
-          // We need ray direction for this pixel
-          double cameraX = 2 * x / (double)w - 1;
-          double rayDirX = dirX + planeX * cameraX;
-          double rayDirY = dirY + planeY * cameraX;
-          
-          double deepX = cam.x + abyssDist * rayDirX;
-          double deepY = cam.y + abyssDist * rayDirY;
-          
-          // Checkerboard pattern for "streets" below
-          int streetX = (int)(deepX);
-          int streetY = (int)(deepY);
-          bool dark = (streetX + streetY) % 2 == 0;
-          
-          Uint8 r = 30, g = 30, b = 35;
-          if (dark) { r = 20; g = 20; b = 25; }
-          
-          // Abyss Shadow (Darker as it goes down? Actually uniform darkness implies depth here)
-          SDL_SetRenderDrawColor(ren, r, g, b, 255);
-          SDL_RenderDrawPoint(ren, x, y);
-      } else {
-          Uint8 r = 100, g = 100, b = 110; // Concrete Gray (Rooftop)
-          if (tile == 3) {
-            r = 0;
-            g = 200;
-            b = 200; // Jump Pad
-          } 
-    
-          float shadow = (float)(y - (h / 2 + (int)cam.pitch)) / (h / 2);
-          shadow *= pulse;
-    
-          SDL_SetRenderDrawColor(ren, (Uint8)(r * shadow), (Uint8)(g * shadow),
-                                 (Uint8)(b * shadow), 255);
-          SDL_RenderDrawPoint(ren, x, y);
-      }
+  SDL_Texture *sceneTarget = nullptr;
+  if (w != outW || h != outH) {
+    sceneTarget = GetSceneTarget(ren, w, h);
+    if (sceneTarget)
+      SDL_SetRenderTarget(ren, sceneTarget);
+  }
+
+  // 1. Parallax sky: copies from the cached panorama
+  m_Sky.Draw(ren, cam.yaw, h / 2 + (int)cam.pitch, w, h);
+
+  // 2. Floor (and ceiling), cast on the CPU and uploaded as one texture
+  RenderFloorCeiling(ren, cam, map);
+
+  CastWalls(cam, map);
+  RenderWalls(ren, cam, roll);
+  RenderSprites(ren, cam, map, reg, roll);
+
+  if (sceneTarget) {
+    SDL_SetRenderTarget(ren, nullptr);
+    SDL_RenderCopy(ren, sceneTarget, nullptr, nullptr);
+  }
+
+  // 3. Post-process at output resolution: one blended fill per region
+  m_PostProcess.Draw(ren, m_PostEffects, outW, outH);
+
+  m_Stats.renderMs = (SDL_GetPerformanceCounter() - startCounter) * 1000.0 /
+                     SDL_GetPerformanceFrequency();
+}
+
+int Raycaster::FloorCeilingTop(const Camera &cam) const {
+  int horizon = m_ScreenHeight / 2 + (int)cam.pitch;
+  if (m_TexturedFloor && m_HasCeiling && cam.z < 1.0f)
+    return 0;
+  return std::max(0, horizon + 1);
+}
+
+void Raycaster::CastFloorCeiling(const Camera &cam, const Map &map,
+                                 Uint32 *pixels, int pitch, int yBegin,
+                                 int yEnd) {
+  int w = m_ScreenWidth;
+  int h = m_ScreenHeight;
+  int horizon = h / 2 + (int)cam.pitch;
+
+  float pulse = m_Shading.GetAmbient();
+  double rayDirX0 = m_View.leftX;
+  double rayDirY0 = m_View.leftY;
+  double rayDirX1 = m_View.rightX;
+  double rayDirY1 = m_View.rightY;
+  bool ceiling = m_TexturedFloor && m_HasCeiling && cam.z < 1.0f;
+  // Row loops compiled for this map, chosen once for the whole band
+  bool abyss = HasAbyssTiles(map);
+  TexturedFloorKernel floorRow = SelectTexturedFloorKernel(abyss, false);
+  TexturedFloorKernel ceilingRow = SelectTexturedFloorKernel(abyss, true);
 
-      floorX += floorStepX;
-      floorY += floorStepY;
+  for (int y = yBegin; y < yEnd; y++) {
+    Uint32 *dst = pixels + (size_t)(y - yBegin) * pitch;
+    FloorRow row;
+    if (y > horizon) {
+      float rowDist = (cam.z * h) / (y - horizon);
+      // Abyss depth (Ground is at -20.0, camera at cam.z)
+      float abyssDist = ((cam.z + 20.0f) * h) / (y - horizon);
+      row.floorX = (float)(cam.x + rowDist * rayDirX0);
+      row.floorY = (float)(cam.y + rowDist * rayDirY0);
+      row.stepX = (float)(rowDist * (rayDirX1 - rayDirX0) / w);
+      row.stepY = (float)(rowDist * (rayDirY1 - rayDirY0) / w);
+      row.deepX = (float)(cam.x + abyssDist * rayDirX0);
+      row.deepY = (float)(cam.y + abyssDist * rayDirY0);
+      row.deepStepX = (float)(abyssDist * (rayDirX1 - rayDirX0) / w);
+      row.deepStepY = (float)(abyssDist * (rayDirY1 - rayDirY0) / w);
+      row.shade = (float)(y - horizon) / (h / 2) * pulse;
+      if (m_TexturedFloor)
+        floorRow(row, map, m_FloorTileTextures.data(), dst, w);
+      else
+        CastFloorRow(row, map, dst, w);
+    } else if (ceiling && y < horizon) {
+      // Mirror of the floor for a ceiling at height 1
+      float rowDist = ((1.0f - cam.z) * h) / (horizon - y);
+      row.floorX = (float)(cam.x + rowDist * rayDirX0);
+      row.floorY = (float)(cam.y + rowDist * rayDirY0);
+      row.stepX = (float)(rowDist * (rayDirX1 - rayDirX0) / w);
+      row.stepY = (float)(rowDist * (rayDirY1 - rayDirY0) / w);
+      row.deepX = row.deepY = row.deepStepX = row.deepStepY = 0.0f;
+      row.shade = (float)(horizon - y) / (h / 2) * pulse;
+      ceilingRow(row, map, m_CeilingTileTextures.data(), dst, w);
     }
   }
+}
 
-  // Add special coloring for lava area? In a raycaster we'd need floor casting.
-  // Let's just implement a faster "strip" based floor color for now if we can't
-  // do full floor casting.
+void Raycaster::RenderFloorCeiling(SDL_Renderer *ren, const Camera &cam,
+                                   const Map &map) {
+  int w = m_ScreenWidth;
+  int h = m_ScreenHeight;
+  int top = FloorCeilingTop(cam);
+  if (top >= h)
+    return;
+  if (w != m_FloorTextureW || h != m_FloorTextureH) {
+    if (m_FloorTexture)
+      SDL_DestroyTexture(m_FloorTexture);
+    m_FloorTexture = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888,
+                                       SDL_TEXTUREACCESS_STREAMING, w, h);
+    if (!m_FloorTexture)
+      std::cerr << "Failed to create floor texture! SDL_Error: "
+                << SDL_GetError() << std::endl;
+    else
+      SDL_SetTextureBlendMode(m_FloorTexture, SDL_BLENDMODE_BLEND);
+    m_FloorTextureW = w;
+    m_FloorTextureH = h;
+  }
+  if (!m_FloorTexture)
+    return;
 
-  RenderWalls(ren, cam, map, roll);
-  RenderSprites(ren, cam, map, reg, roll);
+  SDL_Rect rect = {0, top, w, h - top};
+  void *dst;
+  int pitch;
+  if (SDL_LockTexture(m_FloorTexture, &rect, &dst, &pitch) != 0)
+    return;
+  Uint32 *rows = (Uint32 *)dst;
+  int rowPitch = pitch / (int)sizeof(Uint32);
+  // Ceiling rows only cover tiles with a ceiling image; the rest stays
+  // transparent over the sky
+  int horizon = h / 2 + (int)cam.pitch;
+  for (int y = top; y <= std::min(horizon, h - 1); y++)
+    std::fill(rows + (size_t)(y - top) * rowPitch,
+              rows + (size_t)(y - top) * rowPitch + w, 0u);
+  CastFloorCeiling(cam, map, rows, rowPitch, top, h);
+  SDL_UnlockTexture(m_FloorTexture);
+  SDL_RenderCopy(ren, m_FloorTexture, &rect, &rect);
+}
 
-  // 3. Post-Process: Vignette
-  // We draw a soft darkened border
-  SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
-  for (int i = 0; i < 4; i++) {
-    SDL_SetRenderDrawColor(ren, 0, 0, 0, 40 - (i * 10));
-    SDL_Rect r = {i * 10, i * 10, w - i * 20, h - i * 20};
-    // This is a bit expensive with Rects, let's just do one thick subtle one
-  }
-  // Efficient Vignette
-  SDL_SetRenderDrawColor(ren, 0, 0, 0, 60);
-  // Left
-  SDL_Rect vL = {0, 0, 80, h};
-  SDL_RenderFillRect(ren, &vL);
-  // Right
-  SDL_Rect vR = {w - 80, 0, 80, h};
-  SDL_RenderFillRect(ren, &vR);
-  // Top/Bottom (Subtle)
-  SDL_SetRenderDrawColor(ren, 0, 0, 0, 40);
-  SDL_Rect vT = {0, 0, w, 40};
-  SDL_RenderFillRect(ren, &vT);
-  SDL_Rect vB = {0, h - 40, w, 40};
-  SDL_RenderFillRect(ren, &vB);
-  SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
-}
-
-void Raycaster::RenderWalls(SDL_Renderer *ren, const Camera &cam,
-                            const Map &map, float roll) {
+void Raycaster::CastWalls(const Camera &cam, const Map &map) {
   double posX = cam.x;
   double posY = cam.y;
-  double dirX = std::cos(cam.yaw);
-  double dirY = std::sin(cam.yaw);
-  double planeX = -0.66 * dirY;
-  double planeY = 0.66 * dirX;
 
   int w = m_ScreenWidth;
-  int h = m_ScreenHeight;
-  static std::shared_ptr<Texture> texBrick =
-      TextureManager::LoadTexture(ren, "assets/wall_brick.png");
-  static std::shared_ptr<Texture> texMoss =
-      TextureManager::LoadTexture(ren, "assets/wall_mossy.png");
+  m_WallSide.resize(w);
+  m_WallTexX.resize(w);
+  m_WallTile.resize(w);
 
-  for (int x = 0; x < w; x++) {
-    double cameraX = 2 * x / (double)w - 1;
-    double rayDirX = dirX + planeX * cameraX;
-    double rayDirY = dirY + planeY * cameraX;
-
-    int mapX = int(posX);
-    int mapY = int(posY);
-    double sideDistX, sideDistY;
-    double deltaDistX = (rayDirX == 0) ? 1e30 : std::abs(1 / rayDirX);
-    double deltaDistY = (rayDirY == 0) ? 1e30 : std::abs(1 / rayDirY);
-    double perpWallDist;
-    int stepX, stepY, hit = 0, side;
-
-    if (rayDirX < 0) {
-      stepX = -1;
-      sideDistX = (posX - mapX) * deltaDistX;
+  const Material *materials = m_Materials.data();
+  m_RayTracer.Build(map);
+  RayTraversal traversal = m_RayTraversal;
+  std::atomic<long long> ddaSteps(0);
+
+  const double *rayDirX = m_View.rayDirX.data();
+  const double *rayDirY = m_View.rayDirY.data();
+  auto trace = [&](const double *dirX, const double *dirY, int n,
+                   RayHit *hits) {
+    if (traversal == RayTraversal::Packet) {
+      m_RayTracer.TracePacket(posX, posY, dirX, dirY, n, hits);
+    } else if (traversal == RayTraversal::DistanceField) {
+      for (int i = 0; i < n; i++)
+        hits[i] = m_RayTracer.TraceSkipping(posX, posY, dirX[i], dirY[i]);
     } else {
-      stepX = 1;
-      sideDistX = (mapX + 1.0 - posX) * deltaDistX;
+      for (int i = 0; i < n; i++)
+        hits[i] = m_RayTracer.Trace(posX, posY, dirX[i], dirY[i]);
     }
-    if (rayDirY < 0) {
-      stepY = -1;
-      sideDistY = (posY - mapY) * deltaDistY;
-    } else {
-      stepY = 1;
-      sideDistY = (mapY + 1.0 - posY) * deltaDistY;
+    long long blockSteps = 0;
+    for (int i = 0; i < n; i++)
+      blockSteps += hits[i].steps;
+    ddaSteps += blockSteps;
+  };
+
+  auto storeHit = [&](int x, const RayHit &hit) {
+    double perpWallDist = hit.dist;
+    int side = hit.side;
+    int tile = map.Get(hit.mapX, hit.mapY) & (MAX_MATERIALS - 1);
+    int texW = std::max(1, materials[tile].wall.rect.w);
+
+    double wallX;
+    if (side == 0)
+      wallX = posY + perpWallDist * rayDirY[x];
+    else
+      wallX = posX + perpWallDist * rayDirX[x];
+    wallX -= floor(wallX);
+
+    int texX = int(wallX * double(texW));
+    if (side == 0 && rayDirX[x] > 0)
+      texX = texW - texX - 1;
+    if (side == 1 && rayDirY[x] < 0)
+      texX = texW - texX - 1;
+
+    m_ZBuffer[x] = perpWallDist;
+    m_WallSide[x] = (Uint8)side;
+    m_WallTexX[x] = texX;
+    m_WallTile[x] = tile;
+  };
+
+  // Rays are traced a small block at a time so packet lanes are
+  // neighbouring columns
+  const int BLOCK = 64;
+  auto castColumns = [&](int begin, int end) {
+    RayHit hits[BLOCK];
+    for (int blockStart = begin; blockStart < end; blockStart += BLOCK) {
+      int n = std::min(BLOCK, end - blockStart);
+      trace(rayDirX + blockStart, rayDirY + blockStart, n, hits);
+      for (int i = 0; i < n; i++)
+        storeHit(blockStart + i, hits[i]);
     }
+  };
 
-    while (hit == 0) {
-      if (sideDistX < sideDistY) {
-        sideDistX += deltaDistX;
-        mapX += stepX;
-        side = 0;
+  // Columns strictly between key columns a and b. When both rays hit the
+  // same face of the same cell, every ray in between hits that face too
+  // unless a wall cell sits entirely inside the wedge between them. A unit
+  // cell no farther than R covers at least 1/R radians, so a wedge
+  // narrower than that (with some margin) cannot hide one, and the face
+  // is intersected directly. Anything else is traced in full.
+  std::atomic<int> raysSaved(0);
+  auto fillSpan = [&](int a, const RayHit &hitA, int b, const RayHit &hitB) {
+    if (b - a < 2)
+      return;
+    if (hitA.mapX != hitB.mapX || hitA.mapY != hitB.mapY ||
+        hitA.side != hitB.side) {
+      castColumns(a + 1, b);
+      return;
+    }
+    double lenA = std::sqrt(rayDirX[a] * rayDirX[a] + rayDirY[a] * rayDirY[a]);
+    double lenB = std::sqrt(rayDirX[b] * rayDirX[b] + rayDirY[b] * rayDirY[b]);
+    double range = std::max(hitA.dist * lenA, hitB.dist * lenB);
+    double wedge = std::atan2(
+        std::abs(rayDirX[a] * rayDirY[b] - rayDirY[a] * rayDirX[b]),
+        rayDirX[a] * rayDirX[b] + rayDirY[a] * rayDirY[b]);
+    if (wedge * range >= ADAPTIVE_WEDGE_LIMIT) {
+      castColumns(a + 1, b);
+      return;
+    }
+    // Which face of the cell the rays enter through depends only on where
+    // the camera is, so it is the same for every column of the span
+    for (int x = a + 1; x < b; x++) {
+      RayHit hit = hitA;
+      if (hitA.side == 0) {
+        double faceX = hitA.mapX + (rayDirX[x] < 0 ? 1 : 0);
+        hit.dist = (faceX - posX) / rayDirX[x];
       } else {
-        sideDistY += deltaDistY;
-        mapY += stepY;
-        side = 1;
+        double faceY = hitA.mapY + (rayDirY[x] < 0 ? 1 : 0);
+        hit.dist = (faceY - posY) / rayDirY[x];
       }
-      int tile = map.Get(mapX, mapY);
-      if (tile == 1 || tile == 2)
-        hit = 1;
+      storeHit(x, hit);
     }
+    raysSaved += b - a - 1;
+  };
 
-    if (side == 0)
-      perpWallDist = (sideDistX - deltaDistX);
+  // Traces every ADAPTIVE_COLUMN_STEP-th column plus the last one, then
+  // fills in the spans between them
+  auto castAdaptive = [&](int begin, int end) {
+    int keyX[BLOCK];
+    double keyDirX[BLOCK], keyDirY[BLOCK];
+    RayHit keyHits[BLOCK];
+    RayHit prev{};
+    int prevX = -1;
+    int x = begin;
+    while (x < end) {
+      int n = 0;
+      for (; n < BLOCK && x < end; n++) {
+        keyX[n] = x;
+        keyDirX[n] = rayDirX[x];
+        keyDirY[n] = rayDirY[x];
+        x = x == end - 1 ? end : std::min(x + ADAPTIVE_COLUMN_STEP, end - 1);
+      }
+      trace(keyDirX, keyDirY, n, keyHits);
+      for (int i = 0; i < n; i++) {
+        storeHit(keyX[i], keyHits[i]);
+        if (prevX >= 0)
+          fillSpan(prevX, prev, keyX[i], keyHits[i]);
+        prevX = keyX[i];
+        prev = keyHits[i];
+      }
+    }
+  };
+  auto cast = [&](int begin, int end) {
+    if (m_AdaptiveColumns)
+      castAdaptive(begin, end);
     else
-      perpWallDist = (sideDistY - deltaDistY);
+      castColumns(begin, end);
+  };
 
-    m_ZBuffer[x] = perpWallDist;
+  Uint64 startCounter = SDL_GetPerformanceCounter();
+  if (m_ThreadedWalls) {
+    if (!m_ThreadPool)
+      m_ThreadPool = std::make_unique<ThreadPool>();
+    int threads = m_ThreadPool->GetThreadCount();
+    // A few chunks per thread so uneven columns still balance out
+    int grain = std::max(16, w / (threads * 4));
+    m_ThreadPool->ParallelFor(w, grain, cast);
+    m_Stats.castThreads = threads;
+  } else {
+    cast(0, w);
+    m_Stats.castThreads = 1;
+  }
+  m_Stats.wallCastMs = (SDL_GetPerformanceCounter() - startCounter) * 1000.0 /
+                       SDL_GetPerformanceFrequency();
+  m_Stats.ddaSteps = ddaSteps;
+  m_Stats.raysSaved = raysSaved;
+  m_Stats.raysCast = w - raysSaved;
+}
+
+void Raycaster::RenderWalls(SDL_Renderer *ren, const Camera &cam, float roll) {
+  int w = m_ScreenWidth;
+  int h = m_ScreenHeight;
+
+  if (m_BatchedWalls && SDL_VERSION_ATLEAST(2, 0, 18)) {
+    RenderWallsBatched(ren, cam, roll);
+    return;
+  }
+  m_Stats.wallDrawCalls = w * 5;
+
+  for (int x = 0; x < w; x++) {
+    double perpWallDist = m_ZBuffer[x];
+    int side = m_WallSide[x];
+    int texX = m_WallTexX[x];
     int lineHeight = (int)(h / perpWallDist);
 
     float rollOffset = (x - w / 2) * (roll * 0.02f);
@@ -232,39 +696,17 @@ void Raycaster::RenderWalls(SDL_Renderer *ren, const Camera &cam,
     int drawStart = horizon - (int)((1.0f - cam.z) * lineHeight);
     int drawEnd = horizon + (int)(cam.z * lineHeight);
 
-    int texNum = map.Get(mapX, mapY);
-    Texture *tex = (texNum == 2) ? texMoss.get() : texBrick.get();
-    if (!tex)
-      tex = texBrick.get();
-
-    double wallX;
-    if (side == 0)
-      wallX = posY + perpWallDist * rayDirY;
-    else
-      wallX = posX + perpWallDist * rayDirX;
-    wallX -= floor(wallX);
-
-    int texX = int(wallX * double(tex->GetWidth()));
-    if (side == 0 && rayDirX > 0)
-      texX = tex->GetWidth() - texX - 1;
-    if (side == 1 && rayDirY < 0)
-      texX = tex->GetWidth() - texX - 1;
-
-    SDL_Rect srcRect = {texX, 0, 1, tex->GetHeight()};
-    if (side == 1)
-      tex->SetColorMod(150, 150, 150);
-    else
-      tex->SetColorMod(255, 255, 255);
+    const Material &mat = m_Materials[m_WallTile[x]];
+    if (!mat.wall.IsValid())
+      continue;
+    const AtlasRegion &region =
+        m_WallMipmaps ? WallMip(mat, lineHeight) : mat.wall;
+    Texture *tex = m_Atlas.GetPage(region.page);
 
-    Uint8 r, g, b;
-    tex->GetColorMod(&r, &g, &b);
-    float shadow = 1.0f / (1.0f + perpWallDist * 0.1f);
-    shadow = std::max(0.1f, std::min(1.0f, shadow));
-    SDL_Color fogColor = {180, 200, 220, 255};
-    r = (Uint8)(r * shadow + fogColor.r * (1.0f - shadow));
-    g = (Uint8)(g * shadow + fogColor.g * (1.0f - shadow));
-    b = (Uint8)(b * shadow + fogColor.b * (1.0f - shadow));
-    tex->SetColorMod(r, g, b);
+    SDL_Rect srcRect = {region.rect.x + texX * region.rect.w / mat.wall.rect.w,
+                        region.rect.y, 1, region.rect.h};
+    SDL_Color shade = WallShade(m_Shading, mat, side, perpWallDist);
+    tex->SetColorMod(shade.r, shade.g, shade.b);
 
     // Render Main Wall
     tex->RenderRect(x, drawStart, &srcRect, 1, drawEnd - drawStart);
@@ -281,108 +723,655 @@ void Raycaster::RenderWalls(SDL_Renderer *ren, const Camera &cam,
   }
 }
 
-void Raycaster::RenderSprites(SDL_Renderer *ren, const Camera &cam,
-                              const Map &map, Registry &reg, float roll) {
-  struct DrawableSprite {
-    double dist;
-    Transform3DComponent *trans;
-    BillboardComponent *bill;
-    ParticleComponent *part;
+void Raycaster::RenderWallsBatched(SDL_Renderer *ren, const Camera &cam,
+                                   float roll) {
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  int w = m_ScreenWidth;
+  int h = m_ScreenHeight;
+
+  for (auto &batch : m_WallBatches) {
+    batch.vertices.clear();
+    batch.indices.clear();
+  }
+
+  for (int x = 0; x < w; x++) {
+    double perpWallDist = m_ZBuffer[x];
+    int side = m_WallSide[x];
+    int lineHeight = (int)(h / perpWallDist);
+
+    float rollOffset = (x - w / 2) * (roll * 0.02f);
+    int horizon = h / 2 + (int)cam.pitch + (int)rollOffset;
+    int drawStart = horizon - (int)((1.0f - cam.z) * lineHeight);
+    int drawEnd = horizon + (int)(cam.z * lineHeight);
+    if (drawEnd <= drawStart)
+      continue;
+
+    const Material &mat = m_Materials[m_WallTile[x]];
+    if (!mat.wall.IsValid())
+      continue;
+    const AtlasRegion &region =
+        m_WallMipmaps ? WallMip(mat, lineHeight) : mat.wall;
+    Texture *tex = m_Atlas.GetPage(region.page);
+    if (!tex->GetSDLTexture())
+      continue;
+
+    GeometryBatch *batch = nullptr;
+    for (auto &b : m_WallBatches) {
+      if (b.texture == tex)
+        batch = &b;
+    }
+    if (!batch) {
+      m_WallBatches.push_back({tex, {}, {}});
+      batch = &m_WallBatches.back();
+    }
+
+    // Side shading and fog become the vertex colour; the fake AO is a
+    // gradient to 100/255 over the top and bottom two pixels. Batches are per
+    // atlas page, so usually every wall goes out in a single call.
+    SDL_Color lit = WallShade(m_Shading, mat, side, perpWallDist);
+    SDL_Color occluded = {(Uint8)(lit.r * 100 / 255), (Uint8)(lit.g * 100 / 255),
+                          (Uint8)(lit.b * 100 / 255), 255};
+
+    float lineH = (float)(drawEnd - drawStart);
+    float aoH = std::min(2.0f, lineH * 0.5f);
+    float rowY[4] = {(float)drawStart, drawStart + aoH, drawEnd - aoH,
+                     (float)drawEnd};
+    SDL_Color rowColor[4] = {occluded, lit, lit, occluded};
+
+    // Sample the centre of the texel column so nearest filtering is exact
+    int texX = m_WallTexX[x] * region.rect.w / mat.wall.rect.w;
+    float u = (region.rect.x + texX + 0.5f) / tex->GetWidth();
+    int first = (int)batch->vertices.size();
+    for (int i = 0; i < 4; i++) {
+      float v =
+          region.v0 + (region.v1 - region.v0) * (rowY[i] - drawStart) / lineH;
+      batch->vertices.push_back({{(float)x, rowY[i]}, rowColor[i], {u, v}});
+      batch->vertices.push_back({{(float)x + 1, rowY[i]}, rowColor[i], {u, v}});
+    }
+    for (int i = 0; i < 3; i++) {
+      int top = first + i * 2;
+      int quad[6] = {top, top + 1, top + 2, top + 1, top + 3, top + 2};
+      batch->indices.insert(batch->indices.end(), quad, quad + 6);
+    }
+  }
+
+  int drawCalls = 0;
+  for (auto &batch : m_WallBatches) {
+    if (batch.indices.empty())
+      continue;
+    batch.texture->SetColorMod(255, 255, 255);
+    SDL_RenderGeometry(ren, batch.texture->GetSDLTexture(),
+                       batch.vertices.data(), (int)batch.vertices.size(),
+                       batch.indices.data(), (int)batch.indices.size());
+    drawCalls++;
+  }
+  m_Stats.wallDrawCalls = drawCalls;
+#endif
+}
+
+void Raycaster::CollectSprites(const Camera &cam, const Map &map,
+                               Registry &reg, float roll) {
+  // Walls are final by now; sprites are tested against them span by span
+  m_DepthPyramid.Build(m_ZBuffer);
+  int culled = 0;
+  int occluded = 0;
+  int w = m_ScreenWidth;
+  int h = m_ScreenHeight;
+
+  double nearestWall, farthestWall;
+  m_DepthPyramid.Query(0, w, nearestWall, farthestWall);
+  BuildViewCells(cam, map, farthestWall);
+
+  // Entities keep their slot for as long as they live; only spawns and
+  // deaths touch the slot table and the draw order. Positions are copied
+  // into the packed arrays here so later stages never chase components.
+  m_SpriteFrame++;
+  int live = 0;
+  SpriteArrays &arrays = m_SpriteArrays;
+  auto track = [&](Entity entity, const Transform3DComponent *t,
+                   BillboardComponent *bill, ParticleComponent *part) {
+    Uint64 key = (Uint64)entity * 2 + (part ? 1 : 0);
+    int slot;
+    auto it = m_SpriteSlotIndex.find(key);
+    if (it != m_SpriteSlotIndex.end()) {
+      slot = it->second;
+    } else {
+      if (m_FreeSpriteSlots.empty()) {
+        slot = (int)m_SpriteSlots.size();
+        m_SpriteSlots.emplace_back();
+        arrays.ResizeSlots(m_SpriteSlots.size());
+      } else {
+        slot = m_FreeSpriteSlots.back();
+        m_FreeSpriteSlots.pop_back();
+      }
+      m_SpriteSlotIndex[key] = slot;
+      m_SpriteOrder.push_back(slot);
+    }
+    ProjectedSprite &s = m_SpriteSlots[slot];
+    s.key = key;
+    s.frame = m_SpriteFrame;
+    s.bill = bill;
+    s.part = part;
+    s.z = t->z;
+    s.scale = bill ? bill->scale : part->size * 0.05f;
+    arrays.x[slot] = t->x;
+    arrays.y[slot] = t->y;
+    live++;
   };
-  std::vector<DrawableSprite> sprites;
+
   auto &billboards = reg.View<BillboardComponent>();
   for (auto &pair : billboards) {
-    if (reg.HasComponent<Transform3DComponent>(pair.first)) {
-      auto *t = reg.GetComponent<Transform3DComponent>(pair.first);
-      double dx = t->x - cam.x;
-      double dy = t->y - cam.y;
-      sprites.push_back({dx * dx + dy * dy, t, &pair.second, nullptr});
-    }
+    if (auto *t = reg.GetComponent<Transform3DComponent>(pair.first))
+      track(pair.first, t, &pair.second, nullptr);
   }
   auto &particles = reg.View<ParticleComponent>();
   for (auto &pair : particles) {
-    if (reg.HasComponent<Transform3DComponent>(pair.first)) {
-      auto *t = reg.GetComponent<Transform3DComponent>(pair.first);
-      double dx = t->x - cam.x;
-      double dy = t->y - cam.y;
-      sprites.push_back({dx * dx + dy * dy, t, nullptr, &pair.second});
-    }
+    if (auto *t = reg.GetComponent<Transform3DComponent>(pair.first))
+      track(pair.first, t, nullptr, &pair.second);
   }
-  std::sort(sprites.begin(), sprites.end(),
-            [](const DrawableSprite &a, const DrawableSprite &b) {
-              return a.dist > b.dist;
-            });
 
-  double dirX = std::cos(cam.yaw);
-  double dirY = std::sin(cam.yaw);
-  double planeX = -0.66 * dirY;
-  double planeY = 0.66 * dirX;
-  int w = m_ScreenWidth;
-  int h = m_ScreenHeight;
-  for (const auto &s : sprites) {
-    double spriteX = s.trans->x - cam.x;
-    double spriteY = s.trans->y - cam.y;
-    double invDet = 1.0 / (planeX * dirY - dirX * planeY);
-    double transformX = invDet * (dirY * spriteX - dirX * spriteY);
-    double transformY = invDet * (-planeY * spriteX + planeX * spriteY);
-    if (transformY <= 0.1)
+  // Release the slots of entities that were not seen this frame
+  if (live != (int)m_SpriteOrder.size()) {
+    auto dead = std::remove_if(
+        m_SpriteOrder.begin(), m_SpriteOrder.end(), [&](int slot) {
+          const ProjectedSprite &s = m_SpriteSlots[slot];
+          if (s.frame == m_SpriteFrame)
+            return false;
+          m_SpriteSlotIndex.erase(s.key);
+          m_FreeSpriteSlots.push_back(slot);
+          return true;
+        });
+    m_SpriteOrder.erase(dead, m_SpriteOrder.end());
+  }
+
+  // Sprites in cells that cannot show on screen are dropped before any
+  // per-sprite math; the survivors are packed for the transform kernel.
+  // Sprites larger than MAX_CULLED_SPRITE_SCALE skip the cell test.
+  arrays.ResizeBatch(m_SpriteOrder.size());
+  int count = 0;
+  for (int pos = 0; pos < (int)m_SpriteOrder.size(); pos++) {
+    int slot = m_SpriteOrder[pos];
+    ProjectedSprite &s = m_SpriteSlots[slot];
+    s.visible = false;
+    int cellX = (int)std::floor(arrays.x[slot]);
+    int cellY = (int)std::floor(arrays.y[slot]);
+    if (s.scale <= MAX_CULLED_SPRITE_SCALE && cellX >= 0 &&
+        cellX < Map::WIDTH && cellY >= 0 && cellY < Map::HEIGHT &&
+        !((m_ViewCells[cellY] >> cellX) & 1)) {
+      culled++;
       continue;
+    }
+    arrays.slot[count] = slot;
+    arrays.orderPos[count] = pos;
+    arrays.batchX[count] = arrays.x[slot];
+    arrays.batchY[count] = arrays.y[slot];
+    count++;
+  }
+
+  // Camera-space transform of the survivors in one vectorized pass
+  SpriteCamera view;
+  view.x = cam.x;
+  view.y = cam.y;
+  view.dirX = (float)m_View.dirX;
+  view.dirY = (float)m_View.dirY;
+  view.planeX = -0.66f * view.dirY;
+  view.planeY = 0.66f * view.dirX;
+  view.invDet = 1.0f / (view.planeX * view.dirY - view.dirX * view.planeY);
+  view.halfWidth = (float)(w / 2);
+  view.height = (float)h;
+  view.widthScale = (float)(h * m_PixelAspect);
+  TransformSprites(view, arrays.batchX.data(), arrays.batchY.data(), count,
+                   arrays.Outputs());
 
-    int spriteScreenX = int((w / 2) * (1 + transformX / transformY));
-    float scale =
-        s.bill ? s.bill->scale : (s.part ? s.part->size * 0.05f : 1.0f);
-    int spriteHeight = abs(int(h / transformY)) * scale;
+  // Screen spans, frustum and wall tests on the packed results of batch
+  // entry i. Returns whether any of the sprite is on screen.
+  auto project = [&](int i) {
+    ProjectedSprite &s = m_SpriteSlots[arrays.slot[i]];
+    s.dist = arrays.dist[i];
+    float depth = arrays.depth[i];
+    if (depth <= 0.1f)
+      return false;
+
+    int spriteScreenX = int(arrays.screenX[i]);
+    float projHeight = arrays.projHeight[i];
+    int spriteHeight = abs(int(projHeight)) * s.scale;
 
     float rollOffset = (spriteScreenX - w / 2) * (roll * 0.02f);
     int horizon = h / 2 + (int)cam.pitch + (int)rollOffset;
-    double heightDiff = (s.trans->z - (cam.z - 0.5));
-    int vMoveScreen = int(heightDiff * h / transformY);
-
-    int drawStartY = -spriteHeight / 2 + horizon - vMoveScreen;
-    int drawEndY = spriteHeight / 2 + horizon - vMoveScreen;
-    int spriteWidth = abs(int(h / transformY)) * scale;
-    int drawStartX = -spriteWidth / 2 + spriteScreenX;
-    int drawEndX = spriteWidth / 2 + spriteScreenX;
-    if (drawStartX >= w || drawEndX < 0)
-      continue;
-    int clipStartX = std::max(0, drawStartX);
-    int clipEndX = std::min(w - 1, drawEndX);
+    float heightDiff = s.z - (cam.z - 0.5f);
+    int vMoveScreen = int(heightDiff * projHeight);
 
-    float shadow = 1.0f / (1.0f + transformY * 0.1f);
-    shadow = std::max(0.1f, std::min(1.0f, shadow));
-    SDL_Color fogColor = {180, 200, 220, 255}; // Match daylight sky
+    s.drawStartY = -spriteHeight / 2 + horizon - vMoveScreen;
+    s.drawEndY = spriteHeight / 2 + horizon - vMoveScreen;
+    s.spriteWidth = abs(int(arrays.projWidth[i])) * s.scale;
+    s.drawStartX = -s.spriteWidth / 2 + spriteScreenX;
+    int drawEndX = s.spriteWidth / 2 + spriteScreenX;
+    if (s.drawStartX >= w || drawEndX < 0)
+      return false;
+    s.clipStartX = std::max(0, s.drawStartX);
+    s.clipEndX = std::min(w - 1, drawEndX);
+    if (s.clipEndX <= s.clipStartX)
+      return false;
+
+    double nearest, farthest;
+    m_DepthPyramid.Query(s.clipStartX, s.clipEndX, nearest, farthest);
+    if (depth >= farthest) {
+      occluded++;
+      return false;
+    }
+    s.fullyVisible = depth < nearest;
+    s.depth = depth;
+    s.fog = &m_Shading.Fog(depth);
+    return true;
+  };
+  for (int i = 0; i < count; i++)
+    m_SpriteSlots[arrays.slot[i]].visible = project(i);
+
+  // Back to front, sorting only the sprites that will be drawn. Each goes
+  // back into a draw-order position that a drawn sprite held, so the order
+  // carries over and is nearly right next frame: insertion sort then takes
+  // about one pass. Once it has moved entries more than 4n times (a burst
+  // of spawns, a teleport) std::sort finishes the job, so a shuffled list
+  // costs O(n) extra moves instead of O(n^2).
+  std::vector<int> &drawn = m_DrawnSlots;
+  std::vector<int> &positions = m_DrawnPositions;
+  drawn.clear();
+  positions.clear();
+  for (int i = 0; i < count; i++) {
+    if (m_SpriteSlots[arrays.slot[i]].visible) {
+      drawn.push_back(arrays.slot[i]);
+      positions.push_back(arrays.orderPos[i]);
+    }
+  }
+  auto farther = [this](int a, int b) {
+    return m_SpriteSlots[a].dist > m_SpriteSlots[b].dist;
+  };
+  int n = (int)drawn.size();
+  int moves = 0;
+  int i = 1;
+  for (; i < n && moves <= 4 * n; i++) {
+    int slot = drawn[i];
+    int j = i;
+    for (; j > 0 && farther(slot, drawn[j - 1]); j--)
+      drawn[j] = drawn[j - 1];
+    drawn[j] = slot;
+    moves += i - j;
+  }
+  if (i < n)
+    std::sort(drawn.begin(), drawn.end(), farther);
+
+  m_Sprites.clear();
+  for (int k = 0; k < n; k++) {
+    m_SpriteOrder[positions[k]] = drawn[k];
+    m_Sprites.push_back(&m_SpriteSlots[drawn[k]]);
+  }
+  m_Stats.spritesDrawn = (int)m_Sprites.size();
+  m_Stats.spritesCulled = culled;
+  m_Stats.spritesOccluded = occluded;
+}
+
+void Raycaster::BuildViewCells(const Camera &cam, const Map &map,
+                               double farDepth) {
+  // Camera-space depth and sideways offset of every cell corner. A sprite
+  // overlaps the screen while |lateral| < 0.66 * depth plus its own half
+  // width, which is 0.66 * h * scale / w in lateral units at any depth.
+  // Half a cell more absorbs the pixel rounding in the projection.
+  const int CW = Map::WIDTH + 1;
+  const int CH = Map::HEIGHT + 1;
+  double dirX = m_View.dirX;
+  double dirY = m_View.dirY;
+  double margin = 0.66 * m_ScreenHeight * m_PixelAspect *
+                      MAX_CULLED_SPRITE_SCALE / m_ScreenWidth +
+                  0.5;
+
+  enum { OUT_NEAR = 1, OUT_FAR = 2, OUT_LEFT = 4, OUT_RIGHT = 8 };
+  Uint8 outside[CW * CH];
+  for (int cy = 0; cy < CH; cy++) {
+    for (int cx = 0; cx < CW; cx++) {
+      double dx = cx - cam.x;
+      double dy = cy - cam.y;
+      double depth = dirX * dx + dirY * dy;
+      double lateral = dirX * dy - dirY * dx;
+      double halfWidth = 0.66 * depth + margin;
+      outside[cy * CW + cx] = (depth <= 0.1 ? OUT_NEAR : 0) |
+                              (depth >= farDepth ? OUT_FAR : 0) |
+                              (lateral > halfWidth ? OUT_RIGHT : 0) |
+                              (lateral < -halfWidth ? OUT_LEFT : 0);
+    }
+  }
+
+  // A cell can only be skipped when all four corners are beyond the same
+  // plane; anything straddling the frustum stays in. Cells the camera's
+  // cell cannot see go too.
+  const Uint64 *visible =
+      map.GetVisibleRows((int)std::floor(cam.x), (int)std::floor(cam.y));
+  for (int y = 0; y < Map::HEIGHT; y++) {
+    Uint64 row = 0;
+    for (int x = 0; x < Map::WIDTH; x++) {
+      const Uint8 *c = outside + y * CW + x;
+      if ((c[0] & c[1] & c[CW] & c[CW + 1]) == 0)
+        row |= (Uint64)1 << x;
+    }
+    m_ViewCells[y] = visible ? row & visible[y] : row;
+  }
+}
+
+void Raycaster::RenderSprites(SDL_Renderer *ren, const Camera &cam,
+                              const Map &map, Registry &reg, float roll) {
+  CollectSprites(cam, map, reg, roll);
+
+  // Each visible run of a sprite becomes one quad. Consecutive billboards and
+  // particles on the same atlas page share a geometry submit; anything else
+  // in between flushes it so the back-to-front order is kept.
+  int drawCalls = 0;
+  int visibleStripes = 0;
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  GeometryBatch &batch = m_SpriteBatch;
+  batch.texture = nullptr;
+  batch.vertices.clear();
+  batch.indices.clear();
+  auto flushBatch = [&]() {
+    if (!batch.indices.empty()) {
+      batch.texture->SetColorMod(255, 255, 255);
+      SDL_RenderGeometry(ren, batch.texture->GetSDLTexture(),
+                         batch.vertices.data(), (int)batch.vertices.size(),
+                         batch.indices.data(), (int)batch.indices.size());
+      drawCalls++;
+    }
+    batch.texture = nullptr;
+    batch.vertices.clear();
+    batch.indices.clear();
+  };
+#else
+  auto flushBatch = []() {};
+#endif
+
+  for (const ProjectedSprite *sprite : m_Sprites) {
+    const ProjectedSprite &s = *sprite;
     if (s.bill) {
       Texture *tex = s.bill->texture.get();
       if (!tex)
         continue;
-      Uint8 r = 255, g = 255, b = 255;
-      r = (Uint8)(r * shadow + fogColor.r * (1.0f - shadow));
-      g = (Uint8)(g * shadow + fogColor.g * (1.0f - shadow));
-      b = (Uint8)(b * shadow + fogColor.b * (1.0f - shadow));
-      tex->SetColorMod(r, g, b);
-      for (int stripe = clipStartX; stripe < clipEndX; stripe++) {
-        if (transformY < m_ZBuffer[stripe]) {
-          int texX = int(256 * (stripe - (-spriteWidth / 2 + spriteScreenX)) *
-                         tex->GetWidth() / spriteWidth) /
-                     256;
-          texX = std::max(0, std::min(tex->GetWidth() - 1, texX));
-          SDL_Rect srcRect = {texX, 0, 1, tex->GetHeight()};
-          tex->RenderRect(stripe, drawStartY, &srcRect, 1,
-                          drawEndY - drawStartY);
+      // Prefer the packed atlas copy so billboards share the wall pages
+      SDL_Rect region = {0, 0, tex->GetWidth(), tex->GetHeight()};
+      if (const AtlasRegion *r = m_Atlas.Find(tex)) {
+        region = r->rect;
+        tex = m_Atlas.GetPage(r->page);
+      }
+      SDL_Color tint = s.fog->lit;
+      // Column x shows texel floor((x - s.drawStartX) * region.w / s.spriteWidth).
+      // The extra half step keeps exact texel boundaries from rounding down.
+      auto texelAt = [&](double x) {
+        return ((x - s.drawStartX) * region.w + 0.5) / s.spriteWidth;
+      };
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+      if (tex->GetSDLTexture()) {
+        if (batch.texture != tex) {
+          flushBatch();
+          batch.texture = tex;
         }
+        float pageW = (float)tex->GetWidth();
+        float pageH = (float)tex->GetHeight();
+        float v0 = region.y / pageH;
+        float v1 = (region.y + region.h) / pageH;
+        ForEachVisibleRun(
+            m_ZBuffer, s, [&](int begin, int end) {
+              // Vertices sit on pixel edges, half a column from the centres
+              float u0 = (float)((region.x + texelAt(begin - 0.5)) / pageW);
+              float u1 = (float)((region.x + texelAt(end - 0.5)) / pageW);
+              int first = (int)batch.vertices.size();
+              batch.vertices.push_back(
+                  {{(float)begin, (float)s.drawStartY}, tint, {u0, v0}});
+              batch.vertices.push_back(
+                  {{(float)end, (float)s.drawStartY}, tint, {u1, v0}});
+              batch.vertices.push_back(
+                  {{(float)begin, (float)s.drawEndY}, tint, {u0, v1}});
+              batch.vertices.push_back(
+                  {{(float)end, (float)s.drawEndY}, tint, {u1, v1}});
+              int quad[6] = {first,     first + 1, first + 2,
+                             first + 1, first + 3, first + 2};
+              batch.indices.insert(batch.indices.end(), quad, quad + 6);
+              visibleStripes += end - begin;
+            });
+        continue;
       }
+#endif
+      // Without SDL_RenderGeometry each run is one copy of the texel columns
+      // it covers
+      tex->SetColorMod(tint.r, tint.g, tint.b);
+      ForEachVisibleRun(
+          m_ZBuffer, s, [&](int begin, int end) {
+            int tx0 = std::max(0, std::min(region.w - 1, (int)texelAt(begin)));
+            int tx1 =
+                std::max(tx0, std::min(region.w - 1, (int)texelAt(end - 1)));
+            SDL_Rect srcRect = {region.x + tx0, region.y, tx1 - tx0 + 1,
+                                region.h};
+            tex->RenderRect(begin, s.drawStartY, &srcRect, end - begin,
+                            s.drawEndY - s.drawStartY);
+            drawCalls++;
+            visibleStripes += end - begin;
+          });
+      tex->SetColorMod(255, 255, 255);
     } else if (s.part) {
-      SDL_Color c = s.part->color;
-      c.r = (Uint8)(c.r * shadow + fogColor.r * (1.0f - shadow));
-      c.g = (Uint8)(c.g * shadow + fogColor.g * (1.0f - shadow));
-      c.b = (Uint8)(c.b * shadow + fogColor.b * (1.0f - shadow));
-      SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, c.a);
-      for (int stripe = clipStartX; stripe < clipEndX; stripe++) {
-        if (transformY < m_ZBuffer[stripe])
-          SDL_RenderDrawLine(ren, stripe, drawStartY, stripe, drawEndY);
+      SDL_Color c = s.fog->Apply(s.part->color);
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+      // Fog-blended quads over the white texels, one per visible run, in
+      // whatever batch the neighbouring billboards use
+      const AtlasRegion white = m_WhiteRegionId >= 0
+                                    ? m_Atlas.GetRegion(m_WhiteRegionId)
+                                    : AtlasRegion();
+      Texture *page = white.IsValid() ? m_Atlas.GetPage(white.page) : nullptr;
+      if (page && page->GetSDLTexture()) {
+        if (batch.texture != page) {
+          flushBatch();
+          batch.texture = page;
+        }
+        SDL_FPoint uv = {(white.u0 + white.u1) * 0.5f,
+                         (white.v0 + white.v1) * 0.5f};
+        float y0 = (float)s.drawStartY;
+        float y1 = (float)s.drawEndY + 1; // Columns include both ends
+        ForEachVisibleRun(m_ZBuffer, s, [&](int begin, int end) {
+          int first = (int)batch.vertices.size();
+          batch.vertices.push_back({{(float)begin, y0}, c, uv});
+          batch.vertices.push_back({{(float)end, y0}, c, uv});
+          batch.vertices.push_back({{(float)begin, y1}, c, uv});
+          batch.vertices.push_back({{(float)end, y1}, c, uv});
+          int quad[6] = {first,     first + 1, first + 2,
+                         first + 1, first + 3, first + 2};
+          batch.indices.insert(batch.indices.end(), quad, quad + 6);
+          visibleStripes += end - begin;
+        });
+        continue;
       }
+#endif
+      flushBatch();
+      SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, c.a);
+      ForEachVisibleRun(m_ZBuffer, s,
+                        [&](int begin, int end) {
+                          SDL_Rect run = {begin, s.drawStartY, end - begin,
+                                          s.drawEndY - s.drawStartY + 1};
+                          SDL_RenderFillRect(ren, &run);
+                          drawCalls++;
+                          visibleStripes += end - begin;
+                        });
+    }
+  }
+  flushBatch();
+  m_Stats.spriteDrawCalls = drawCalls;
+  m_Stats.spriteStripes = visibleStripes;
+}
+
+void Raycaster::RenderSoftware(const Camera &cam, const Map &map,
+                               Registry &reg, float roll) {
+  int w = m_ScreenWidth;
+  int h = m_ScreenHeight;
+  m_Framebuffer.resize((size_t)w * h);
+  Uint32 *pixels = m_Framebuffer.data();
+
+  // Sky: rows of the cached panorama down to the horizon
+  int horizon = h / 2 + (int)cam.pitch;
+  m_Sky.DrawSoftware(pixels, cam.yaw, horizon, w, h);
+
+  // Floor (and ceiling): one kernel call per row
+  int top = FloorCeilingTop(cam);
+  if (top < h)
+    CastFloorCeiling(cam, map, pixels + (size_t)top * w, w, top, h);
+
+  CastWalls(cam, map);
+  RenderWallsSoftware(cam, roll);
+  RenderSpritesSoftware(cam, map, reg, roll);
+
+  // Vignette, tints and film effects in one pass over the framebuffer
+  m_PostProcess.Apply(m_PostEffects, pixels, w, h, m_OutputWidth,
+                      m_OutputHeight, m_PostFrame++);
+}
+
+void Raycaster::RenderWallsSoftware(const Camera &cam, float roll) {
+  int w = m_ScreenWidth;
+  WallFrame frame;
+  frame.pixels = m_Framebuffer.data();
+  frame.width = w;
+  frame.height = m_ScreenHeight;
+  frame.dist = m_ZBuffer.data();
+  frame.side = m_WallSide.data();
+  frame.texX = m_WallTexX.data();
+  frame.tile = m_WallTile.data();
+  frame.materials = m_WallMaterials.data();
+  frame.shading = &m_Shading;
+  frame.pitch = (int)cam.pitch;
+  frame.camZ = cam.z;
+  frame.roll = roll;
+  frame.mipmaps = m_WallMipmaps;
+
+  // Pick the column loop compiled for this frame's features once, instead
+  // of testing roll, shading, AO and mipmaps per column and per pixel
+  unsigned features = GetWallFeatures(frame);
+  WallKernel kernel = SelectWallKernel(features);
+  m_Stats.wallFeatures = features;
+  auto drawColumns = [&](int begin, int end) { kernel(frame, begin, end); };
+
+  // Columns write disjoint pixels, so they rasterize in parallel too
+  if (m_ThreadedWalls && m_ThreadPool) {
+    int grain = std::max(16, w / (m_ThreadPool->GetThreadCount() * 4));
+    m_ThreadPool->ParallelFor(w, grain, drawColumns);
+  } else {
+    drawColumns(0, w);
+  }
+}
+
+void Raycaster::RenderSpritesSoftware(const Camera &cam, const Map &map,
+                                      Registry &reg, float roll) {
+  CollectSprites(cam, map, reg, roll);
+
+  int w = m_ScreenWidth;
+  int h = m_ScreenHeight;
+  Uint32 *pixels = m_Framebuffer.data();
+
+  for (const ProjectedSprite *sprite : m_Sprites) {
+    const ProjectedSprite &s = *sprite;
+    int drawStartY = s.drawStartY;
+    int drawEndY = s.drawEndY;
+    if (s.bill) {
+      Texture *tex = s.bill->texture.get();
+      if (!tex || !tex->GetPixels() || s.spriteWidth <= 0 ||
+          drawEndY <= drawStartY)
+        continue;
+      int modR = s.fog->lit.r, modG = s.fog->lit.g, modB = s.fog->lit.b;
+      // Unfogged sprites skip the per-texel colour modulation
+      bool lit = modR == 255 && modG == 255 && modB == 255;
+      int texW = tex->GetWidth();
+      int texH = tex->GetHeight();
+      const Uint32 *texels = tex->GetPixels();
+      int spriteH = drawEndY - drawStartY;
+      int y0 = std::max(0, drawStartY);
+      int y1 = std::min(h, drawEndY);
+      // First screen row (from drawStartY) that shows texel row t
+      auto firstRow = [&](int t) {
+        return int(((Sint64)t * spriteH + texH - 1) / texH);
+      };
+      int whole = texH / spriteH;
+      int frac = texH % spriteH;
+      ForEachVisibleRun(m_ZBuffer, s, [&](int begin, int end) {
+        for (int stripe = begin; stripe < end; stripe++) {
+          int texX =
+              int(256 * (stripe - s.drawStartX) * texW / s.spriteWidth) / 256;
+          texX = std::max(0, std::min(texW - 1, texX));
+          int runCount;
+          const Texture::OpaqueRun *runs = tex->GetOpaqueRuns(texX, runCount);
+          // Only the screen rows covered by opaque texels are visited.
+          // Screen row y shows texel row (y - drawStartY) * texH / spriteH.
+          for (int r = 0; r < runCount; r++) {
+            int ys = std::max(y0, drawStartY + firstRow(runs[r].start));
+            int ye = std::min(y1, drawStartY + firstRow(runs[r].end));
+            if (ys >= ye)
+              continue;
+            // Texel row and remainder of (ys - drawStartY) * texH / spriteH,
+            // advanced in integers
+            Sint64 num = (Sint64)(ys - drawStartY) * texH;
+            int texY = int(num / spriteH);
+            int rem = int(num % spriteH);
+            const Uint32 *column = texels + texX;
+            Uint32 *dst = pixels + ys * w + stripe;
+            if (lit)
+              DrawBillboardRows<false>(dst, w, column, texW, texY, rem, whole,
+                                       frac, spriteH, ye - ys, modR, modG,
+                                       modB);
+            else
+              DrawBillboardRows<true>(dst, w, column, texW, texY, rem, whole,
+                                      frac, spriteH, ye - ys, modR, modG,
+                                      modB);
+          }
+        }
+      });
+    } else if (s.part) {
+      SDL_Color c = s.fog->Apply(s.part->color);
+      Uint32 color = PackRGB(c.r, c.g, c.b);
+      // Particle columns are inclusive of both ends, like SDL_RenderDrawLine
+      int y0 = std::max(0, std::min(drawStartY, drawEndY));
+      int y1 = std::min(h - 1, std::max(drawStartY, drawEndY));
+      ForEachVisibleRun(m_ZBuffer, s, [&](int begin, int end) {
+        for (int y = y0; y <= y1; y++)
+          std::fill(pixels + y * w + begin, pixels + y * w + end, color);
+      });
+    }
+  }
+}
+
+void Raycaster::PresentFramebuffer(SDL_Renderer *ren) {
+  int w = m_ScreenWidth;
+  int h = m_ScreenHeight;
+  if (w != m_FrameTextureW || h != m_FrameTextureH) {
+    for (SDL_Texture *&tex : m_FrameTextures) {
+      if (tex)
+        SDL_DestroyTexture(tex);
+      tex = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888,
+                              SDL_TEXTUREACCESS_STREAMING, w, h);
+      if (!tex)
+        std::cerr << "Failed to create framebuffer texture! SDL_Error: "
+                  << SDL_GetError() << std::endl;
+    }
+    m_FrameTextureW = w;
+    m_FrameTextureH = h;
+  }
+
+  SDL_Texture *tex = m_FrameTextures[m_FrameIndex];
+  m_FrameIndex ^= 1;
+  if (!tex)
+    return;
+
+  void *dst;
+  int pitch;
+  if (SDL_LockTexture(tex, nullptr, &dst, &pitch) == 0) {
+    const Uint32 *src = m_Framebuffer.data();
+    if (pitch == w * (int)sizeof(Uint32)) {
+      memcpy(dst, src, (size_t)w * h * sizeof(Uint32));
+    } else {
+      for (int y = 0; y < h; y++)
+        memcpy((Uint8 *)dst + y * pitch, src + y * w, w * sizeof(Uint32));
     }
+    SDL_UnlockTexture(tex);
   }
+  SDL_RenderCopy(ren, tex, nullptr, nullptr);
 }
 
-} // namespace PixelsEngine
\ No newline at end of file
+} // namespace PixelsEngine
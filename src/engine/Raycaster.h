@@ -1,41 +1,343 @@
 #pragma once
 #include "Camera.h"
+#include "DepthPyramid.h"
 #include "ECS.h"
+#include "FloorKernel.h"
 #include "Map.h"
+#include "PostProcess.h"
+#include "RayTrace.h"
+#include "Shading.h"
+#include "SkyPanorama.h"
+#include "SpriteKernel.h"
 #include "Texture.h"
+#include "TextureAtlas.h"
+#include "ThreadPool.h"
+#include "WallKernel.h"
 #include <SDL2/SDL.h>
-#include <map>
+#include <array>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace PixelsEngine {
 
+struct BillboardComponent;
+struct ParticleComponent;
+
+// How a frame is produced. SDLRenderer issues draw calls per column/pixel;
+// Software rasterizes into a CPU pixel buffer that is uploaded once.
+enum class RenderBackend { SDLRenderer, Software };
+
+// How wall rays walk the grid. Packet traces neighbouring columns together
+// with SIMD and produces the same hits as Scalar. DistanceField jumps across
+// open space using the map's wall distances.
+enum class RayTraversal { Scalar, Packet, DistanceField };
+
+struct RenderStats {
+  double renderMs = 0.0; // CPU time spent inside Render()
+  double wallCastMs = 0.0;
+  int castThreads = 1;
+  long long ddaSteps = 0; // Summed over all wall rays this frame
+  int raysCast = 0;
+  int raysSaved = 0; // Columns filled in between rays by adaptive columns
+  int wallDrawCalls = 0;
+  int spriteDrawCalls = 0;
+  int spriteStripes = 0; // Visible sprite columns (one draw call each before)
+  int spritesDrawn = 0;
+  int spritesCulled = 0;   // Outside the view frustum (by map cell)
+  int spritesOccluded = 0; // Dropped by the depth pyramid before sorting
+  int viewWidth = 0; // Internal resolution the 3D view was cast at
+  int viewHeight = 0;
+  unsigned wallFeatures = 0; // WallFeature bits of the software wall kernel
+};
+
 class Raycaster {
 public:
   Raycaster();
   ~Raycaster();
 
+  static const int MAX_MATERIALS = 256;
+
   void Init(SDL_Renderer *ren);
-  void LoadTexture(int id, const std::string &path);
+
+  // Material registration. Images are packed into the texture atlas the
+  // next time a frame is rendered.
+  void LoadTexture(int id, const std::string &path,
+                   Uint8 flags = MAT_SIDE_SHADE | MAT_FOG);
+  void LoadFloorTexture(int id, const std::string &path);
+  // Ceiling at height 1 over tiles that have an image; others show the sky
+  void LoadCeilingTexture(int id, const std::string &path);
+  void AddSpriteTexture(const std::shared_ptr<Texture> &texture);
+
+  const Material &GetMaterial(int tile) const {
+    return m_Materials[tile & (MAX_MATERIALS - 1)];
+  }
 
   // Main render function
   void Render(SDL_Renderer *ren, const Camera &cam, const Map &map,
               Registry &reg, float roll = 0.0f);
 
+  void SetBackend(RenderBackend backend) { m_Backend = backend; }
+  RenderBackend GetBackend() const { return m_Backend; }
+  static const char *GetBackendName(RenderBackend backend);
+
+  // Cast wall columns in parallel on a persistent worker pool
+  void SetThreadedWalls(bool enabled) { m_ThreadedWalls = enabled; }
+  bool IsThreadedWalls() const { return m_ThreadedWalls; }
+
+  // Submit walls as one SDL_RenderGeometry batch per texture (SDL >= 2.0.18)
+  void SetBatchedWalls(bool enabled) { m_BatchedWalls = enabled; }
+  bool IsBatchedWalls() const { return m_BatchedWalls; }
+
+  // Distance fog shared by walls, sprites and particles. Takes effect on
+  // the next frame.
+  void SetFog(SDL_Color color, float density) {
+    m_Shading.SetFog(color, density);
+  }
+  const Shading &GetShading() const { return m_Shading; }
+
+  // Effects applied over the finished 3D view, in a single pass
+  void SetPostEffects(const PostEffects &effects) { m_PostEffects = effects; }
+  const PostEffects &GetPostEffects() const { return m_PostEffects; }
+
+  // Perspective-correct floor (and ceiling) textures per tile instead of
+  // flat colours
+  void SetTexturedFloor(bool enabled) { m_TexturedFloor = enabled; }
+  bool IsTexturedFloor() const { return m_TexturedFloor; }
+
+  // Trace every ADAPTIVE_COLUMN_STEP-th column and fill in the columns
+  // between two rays that hit the same cell face, tracing the rest in full
+  void SetAdaptiveColumns(bool enabled) { m_AdaptiveColumns = enabled; }
+  bool IsAdaptiveColumns() const { return m_AdaptiveColumns; }
+  static const int ADAPTIVE_COLUMN_STEP = 8;
+
+  // Sample walls from the mip level that matches their on-screen height
+  void SetWallMipmaps(bool enabled) { m_WallMipmaps = enabled; }
+  bool IsWallMipmaps() const { return m_WallMipmaps; }
+
+  // Cast the 3D view at a fraction of the output size and stretch it back
+  // up with nearest filtering. The two axes scale independently.
+  void SetRenderScale(float scaleX, float scaleY);
+  float GetRenderScaleX() const { return m_RenderScaleX; }
+  float GetRenderScaleY() const { return m_RenderScaleY; }
+  static constexpr float MIN_RENDER_SCALE = 0.25f;
+
+  void SetRayTraversal(RayTraversal traversal) { m_RayTraversal = traversal; }
+  RayTraversal GetRayTraversal() const { return m_RayTraversal; }
+  static const char *GetRayTraversalName(RayTraversal traversal);
+
+  const RenderStats &GetStats() const { return m_Stats; }
+
 private:
-  void RenderWalls(SDL_Renderer *ren, const Camera &cam, const Map &map,
-                   float roll);
+  // Camera vectors and the ray through every column for one frame. The
+  // passes read these instead of each taking cos/sin of the yaw; the table
+  // is only refilled when the yaw or the view width changes.
+  struct ViewSetup {
+    float yaw = 0.0f;
+    int width = 0; // 0 until the first Update
+    double dirX = 1.0, dirY = 0.0;
+    double planeX = 0.0, planeY = 0.66;
+    // Rays through the left and right edges of the view
+    double leftX = 1.0, leftY = -0.66;
+    double rightX = 1.0, rightY = 0.66;
+    std::vector<double> rayDirX, rayDirY; // One per column
+    void Update(float yaw, int width);
+  };
+
+  // Runs the DDA for every column and fills the per-column hit arrays
+  void CastWalls(const Camera &cam, const Map &map);
+  void RenderWalls(SDL_Renderer *ren, const Camera &cam, float roll);
+  void RenderWallsBatched(SDL_Renderer *ren, const Camera &cam, float roll);
+  // A billboard or particle and where it landed on the view this frame
+  struct ProjectedSprite {
+    Uint64 key = 0;     // Entity * 2, + 1 for particles
+    unsigned frame = 0; // Last frame the entity was seen alive
+    BillboardComponent *bill = nullptr;
+    ParticleComponent *part = nullptr;
+    float z = 0.0f;
+    float scale = 1.0f;
+    bool visible = false;
+    float dist = 0.0f; // Squared distance from the camera, for the draw order
+    // Set when visible
+    double depth = 0.0; // Camera-space depth compared against m_ZBuffer
+    int drawStartX = 0, spriteWidth = 0;
+    int clipStartX = 0, clipEndX = 0; // On-screen columns [start, end)
+    int drawStartY = 0, drawEndY = 0;
+    const FogLevel *fog = nullptr; // From m_Shading at the sprite's depth
+    bool fullyVisible = false; // In front of the walls in every column
+  };
+
+  // Projects every billboard and particle, drops those hidden behind the
+  // walls and lists the rest back to front in m_Sprites
+  void CollectSprites(const Camera &cam, const Map &map, Registry &reg,
+                      float roll);
+
+  // Marks the map cells that can hold a visible sprite: in front of the
+  // camera, nearer than farDepth, within the horizontal field of view
+  // (widened by the largest sprite half-width) and in the potentially
+  // visible set of the camera's cell. Sprites larger than
+  // MAX_CULLED_SPRITE_SCALE skip the cell test.
+  void BuildViewCells(const Camera &cam, const Map &map, double farDepth);
+  static constexpr float MAX_CULLED_SPRITE_SCALE = 2.0f;
   void RenderSprites(SDL_Renderer *ren, const Camera &cam, const Map &map,
                      Registry &reg, float roll);
-  void RenderFloorCeiling(SDL_Renderer *ren,
-                          const Camera &cam); // Optional/Solid color
+  // Floor and ceiling rows [yBegin, yEnd) into `pixels` (row yBegin first,
+  // `pitch` pixels apart). Shared by both backends.
+  void CastFloorCeiling(const Camera &cam, const Map &map, Uint32 *pixels,
+                        int pitch, int yBegin, int yEnd);
+  // First row CastFloorCeiling draws: below the horizon, or 0 with a ceiling
+  int FloorCeilingTop(const Camera &cam) const;
+  // SDL_Renderer path: casts into m_FloorTexture and draws it in one copy
+  void RenderFloorCeiling(SDL_Renderer *ren, const Camera &cam,
+                          const Map &map);
+  // Re-tiles the floor and ceiling images after new ones were loaded
+  void UpdateFloorTextures();
+
+  // Software backend: everything is written into m_Framebuffer
+  void RenderSoftware(const Camera &cam, const Map &map, Registry &reg,
+                      float roll);
+  void RenderWallsSoftware(const Camera &cam, float roll);
+  void RenderSpritesSoftware(const Camera &cam, const Map &map,
+                             Registry &reg, float roll);
+  void PresentFramebuffer(SDL_Renderer *ren);
+
+  // Render target the SDL_Renderer path draws into when the view is scaled
+  // down. Returns nullptr if render targets are unsupported.
+  SDL_Texture *GetSceneTarget(SDL_Renderer *ren, int w, int h);
+
+  // Packs newly registered images and refreshes the material UVs
+  void UpdateAtlas(SDL_Renderer *ren);
 
-  std::map<int, std::shared_ptr<Texture>> m_Textures;
+  SDL_Renderer *m_Renderer = nullptr;
+  TextureAtlas m_Atlas;
+  int m_WhiteRegionId = -1;
+  std::array<Material, MAX_MATERIALS> m_Materials;
+  // Region of each wall mip level, -1 past the last
+  std::array<std::array<int, MAX_WALL_MIPS>, MAX_MATERIALS> m_WallRegionIds;
+  // m_Materials' wall mips as texel pointers for the software wall pass
+  std::array<WallMaterial, MAX_MATERIALS> m_WallMaterials;
+  std::array<int, MAX_MATERIALS> m_FloorRegionIds;
+  std::array<std::shared_ptr<Texture>, MAX_MATERIALS> m_FloorImages;
+  std::array<std::shared_ptr<Texture>, MAX_MATERIALS> m_CeilingImages;
+  FloorTextureSet m_FloorTextures;
+  // Texels of each tile's floor/ceiling in m_FloorTextures, nullptr if none
+  std::array<const Uint32 *, MAX_MATERIALS> m_FloorTileTextures = {};
+  std::array<const Uint32 *, MAX_MATERIALS> m_CeilingTileTextures = {};
+  bool m_FloorTexturesDirty = false;
+  bool m_HasCeiling = false;
+  bool m_TexturedFloor = true;
+  SDL_Texture *m_FloorTexture = nullptr;
+  int m_FloorTextureW = 0;
+  int m_FloorTextureH = 0;
+
+  ViewSetup m_View;
   std::vector<double> m_ZBuffer; // Distance to wall for each column
 
+  // Per-column wall hit data written by CastWalls (m_ZBuffer holds the
+  // distance)
+  std::vector<Uint8> m_WallSide;
+  std::vector<int> m_WallTexX;
+  std::vector<int> m_WallTile;
+  DepthPyramid m_DepthPyramid;
+  static_assert(Map::WIDTH <= 64, "view cell rows are one Uint64");
+  Uint64 m_ViewCells[Map::HEIGHT] = {};
+  // Persistent draw list. Each live billboard/particle owns a slot until it
+  // dies. m_SpriteOrder keeps the slots roughly back to front across
+  // frames: each frame sorts the sprites it draws among their own places.
+  std::vector<ProjectedSprite> m_SpriteSlots;
+  std::vector<int> m_FreeSpriteSlots;
+  std::unordered_map<Uint64, int> m_SpriteSlotIndex;
+  std::vector<int> m_SpriteOrder;
+  std::vector<int> m_DrawnSlots;     // This frame's drawn sprites, sorted
+  std::vector<int> m_DrawnPositions; // Their places in m_SpriteOrder
+  // Structure of arrays for the SIMD transform kernel. x and y are indexed
+  // by slot; the rest by batch entry, where the batch holds only the sprites
+  // that passed the view-cell test and slot[i] is entry i's slot.
+  struct SpriteArrays {
+    std::vector<float> x, y;
+    std::vector<int> slot;
+    std::vector<int> orderPos; // Index of the entry in m_SpriteOrder
+    std::vector<float> batchX, batchY;
+    std::vector<float> dist, depth, screenX, projHeight, projWidth;
+    void ResizeSlots(size_t n) {
+      x.resize(n);
+      y.resize(n);
+    }
+    void ResizeBatch(size_t n) {
+      slot.resize(n);
+      orderPos.resize(n);
+      for (auto *v : {&batchX, &batchY, &dist, &depth, &screenX, &projHeight,
+                      &projWidth})
+        v->resize(n);
+    }
+    SpriteTransforms Outputs() {
+      return {dist.data(), depth.data(), screenX.data(), projHeight.data(),
+              projWidth.data()};
+    }
+  };
+  SpriteArrays m_SpriteArrays;
+  unsigned m_SpriteFrame = 0;
+  std::vector<const ProjectedSprite *> m_Sprites; // Visible, in draw order
+
+  SkyPanorama m_Sky;
+  PostProcess m_PostProcess;
+  PostEffects m_PostEffects;
+  Uint32 m_PostFrame = 0; // Seeds the film grain
+  Shading m_Shading;
+
+  RayTracer m_RayTracer;
+  // SSE2 packets hold two doubles per register and only break even with
+  // the scalar loop, so packets are the default on AVX2 builds only
+  RayTraversal m_RayTraversal = RayTracer::GetPacketWidth() >= 8
+                                    ? RayTraversal::Packet
+                                    : RayTraversal::Scalar;
+
+  bool m_ThreadedWalls = false;
+  bool m_WallMipmaps = true;
+  bool m_AdaptiveColumns = false;
+  // Largest wedge angle * range that cannot hide a whole wall cell (1)
+  static constexpr double ADAPTIVE_WEDGE_LIMIT = 0.9;
+  std::unique_ptr<ThreadPool> m_ThreadPool;
+
+#if SDL_VERSION_ATLEAST(2, 0, 18)
+  struct GeometryBatch {
+    Texture *texture = nullptr;
+    std::vector<SDL_Vertex> vertices;
+    std::vector<int> indices;
+  };
+  std::vector<GeometryBatch> m_WallBatches;
+  GeometryBatch m_SpriteBatch;
+  bool m_BatchedWalls = true;
+#else
+  bool m_BatchedWalls = false;
+#endif
+
+  // Internal view size (what everything is cast at) and the logical output
+  // size it is stretched to
   int m_ScreenWidth;
   int m_ScreenHeight;
+  int m_OutputWidth = 0;
+  int m_OutputHeight = 0;
+  float m_RenderScaleX = 1.0f;
+  float m_RenderScaleY = 1.0f;
+  // Width of an internal pixel relative to its height, for sprite sizes
+  double m_PixelAspect = 1.0;
+  SDL_Texture *m_SceneTarget = nullptr;
+  int m_SceneTargetW = 0;
+  int m_SceneTargetH = 0;
+
+  RenderBackend m_Backend = RenderBackend::SDLRenderer;
+  RenderStats m_Stats;
+
+  // CPU framebuffer (ARGB8888) and the streaming textures it is uploaded
+  // through. Two textures are alternated so we never lock the one the GPU
+  // may still be reading from.
+  std::vector<Uint32> m_Framebuffer;
+  SDL_Texture *m_FrameTextures[2] = {nullptr, nullptr};
+  int m_FrameTextureW = 0;
+  int m_FrameTextureH = 0;
+  int m_FrameIndex = 0;
 };
 
 } // namespace PixelsEngine
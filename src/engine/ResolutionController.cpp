@@ -0,0 +1,68 @@
+#include "ResolutionController.h"
+#include <algorithm>
+#include <cmath>
+
+namespace PixelsEngine {
+
+namespace {
+
+const double SMOOTHING = 0.1; // Weight of the newest frame in the average
+const double SCALE_DOWN_ABOVE = 1.05; // Fractions of the target frame time
+const double SCALE_UP_BELOW = 0.75;
+const int FRAMES_BEFORE_SCALE_UP = 60;
+const int COOLDOWN_FRAMES = 15; // Let the average catch up after a change
+const float SCALE_UP_STEP = 1.05f;
+
+} // namespace
+
+void ResolutionController::SetScaleRange(float minScale, float maxScale) {
+  m_MinScale = std::max(0.1f, std::min(minScale, 1.0f));
+  m_MaxScale = std::max(m_MinScale, std::min(maxScale, 1.0f));
+  m_Scale = std::max(m_MinScale, std::min(m_Scale, m_MaxScale));
+}
+
+bool ResolutionController::Update(double frameMs) {
+  if (frameMs <= 0.0)
+    return false;
+  // Seed with the first sample so start-up does not read as a fast frame
+  m_SmoothedMs = m_SmoothedMs > 0.0
+                     ? m_SmoothedMs + (frameMs - m_SmoothedMs) * SMOOTHING
+                     : frameMs;
+  if (m_Cooldown > 0) {
+    m_Cooldown--;
+    return false;
+  }
+
+  float next = m_Scale;
+  if (m_SmoothedMs > m_TargetMs * SCALE_DOWN_ABOVE) {
+    // Cost follows the pixel count, which goes with the square of the
+    // scale. Aim a little under the target and never drop more than 20%
+    // at once.
+    double ratio = std::sqrt(m_TargetMs * 0.9 / m_SmoothedMs);
+    next = m_Scale * (float)std::max(0.8, std::min(ratio, 0.95));
+    m_FramesUnderBudget = 0;
+  } else if (m_SmoothedMs < m_TargetMs * SCALE_UP_BELOW) {
+    if (++m_FramesUnderBudget >= FRAMES_BEFORE_SCALE_UP) {
+      next = m_Scale * SCALE_UP_STEP;
+      m_FramesUnderBudget = 0;
+    }
+  } else {
+    m_FramesUnderBudget = 0;
+  }
+
+  next = std::max(m_MinScale, std::min(next, m_MaxScale));
+  if (next == m_Scale)
+    return false;
+  m_Scale = next;
+  m_Cooldown = COOLDOWN_FRAMES;
+  return true;
+}
+
+void ResolutionController::Reset() {
+  m_Scale = m_MaxScale;
+  m_SmoothedMs = 0.0;
+  m_FramesUnderBudget = 0;
+  m_Cooldown = 0;
+}
+
+} // namespace PixelsEngine
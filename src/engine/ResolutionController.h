@@ -0,0 +1,35 @@
+#pragma once
+
+namespace PixelsEngine {
+
+// Picks a render scale that keeps the frame time near a target. The scale
+// drops as soon as the smoothed frame time goes over budget and only climbs
+// back after it has stayed well under budget for a while, so it settles
+// instead of bouncing between two sizes.
+class ResolutionController {
+public:
+  void SetTargetFrameMs(double ms) { m_TargetMs = ms; }
+  double GetTargetFrameMs() const { return m_TargetMs; }
+
+  void SetScaleRange(float minScale, float maxScale);
+
+  // Feeds the time one frame took. Returns true when the scale changed.
+  bool Update(double frameMs);
+
+  // Back to full scale with no history
+  void Reset();
+
+  float GetScale() const { return m_Scale; }
+  double GetSmoothedFrameMs() const { return m_SmoothedMs; }
+
+private:
+  double m_TargetMs = 1000.0 / 60.0;
+  float m_MinScale = 0.5f;
+  float m_MaxScale = 1.0f;
+  float m_Scale = 1.0f;
+  double m_SmoothedMs = 0.0;
+  int m_FramesUnderBudget = 0;
+  int m_Cooldown = 0; // Frames to wait before the next change
+};
+
+} // namespace PixelsEngine
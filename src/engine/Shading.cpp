@@ -0,0 +1,43 @@
+#include "Shading.h"
+#include <algorithm>
+#include <cmath>
+
+namespace PixelsEngine {
+
+Shading::Shading() { Rebuild(); }
+
+void Shading::SetFog(SDL_Color color, float density) {
+  m_FogColor = color;
+  m_FogDensity = std::max(0.0f, density);
+  Rebuild();
+}
+
+void Shading::Rebuild() {
+  // Stop one step after visibility bottoms out; everything further away
+  // reads the last entry
+  float end = MAX_DISTANCE;
+  if (m_FogDensity > 0.0f)
+    end = std::min(end, (1.0f / MIN_VISIBILITY - 1.0f) / m_FogDensity);
+  int count = (int)std::ceil(end * STEPS_PER_UNIT) + 2;
+
+  m_Levels.resize(count);
+  for (int i = 0; i < count; i++) {
+    float dist = (float)i / STEPS_PER_UNIT;
+    float v = 1.0f / (1.0f + dist * m_FogDensity);
+    v = std::max(MIN_VISIBILITY, std::min(1.0f, v));
+    auto blend = [&](float base, Uint8 fog) {
+      return (Uint8)(base * v + fog * (1.0f - v));
+    };
+    FogLevel &level = m_Levels[i];
+    level.visibility = (int)std::lround(v * 256.0f);
+    level.fog = {(Uint8)(m_FogColor.r * (1.0f - v)),
+                 (Uint8)(m_FogColor.g * (1.0f - v)),
+                 (Uint8)(m_FogColor.b * (1.0f - v)), 255};
+    level.lit = {blend(255.0f, m_FogColor.r), blend(255.0f, m_FogColor.g),
+                 blend(255.0f, m_FogColor.b), 255};
+    level.side = {blend(150.0f, m_FogColor.r), blend(150.0f, m_FogColor.g),
+                  blend(150.0f, m_FogColor.b), 255};
+  }
+}
+
+} // namespace PixelsEngine
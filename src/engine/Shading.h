@@ -0,0 +1,69 @@
+#pragma once
+#include <SDL2/SDL.h>
+#include <vector>
+
+namespace PixelsEngine {
+
+// Fog at one distance
+struct FogLevel {
+  int visibility; // 0..256: share of the surface colour that survives
+  SDL_Color fog;  // Fog colour * (1 - visibility), added on top
+  SDL_Color lit;  // Fogged modulation for fully lit surfaces (255)
+  SDL_Color side; // Fogged modulation for shaded Y-facing walls (150)
+
+  // Any colour seen through this much fog
+  SDL_Color Apply(SDL_Color c) const {
+    return {(Uint8)(((c.r * visibility) >> 8) + fog.r),
+            (Uint8)(((c.g * visibility) >> 8) + fog.g),
+            (Uint8)(((c.b * visibility) >> 8) + fog.b), c.a};
+  }
+};
+
+// Distance fog and ambient light shared by every render pass. Visibility is
+// 1 / (1 + dist * density), clamped to [MIN_VISIBILITY, 1], tabulated per
+// 1/STEPS_PER_UNIT of distance so passes look up ready-made colours. Setting
+// a new fog colour or density only rebuilds the table.
+class Shading {
+public:
+  static const int STEPS_PER_UNIT = 32;
+  static constexpr float MIN_VISIBILITY = 0.1f;
+  // Where the table stops when the fog is too thin to reach MIN_VISIBILITY
+  static constexpr float MAX_DISTANCE = 256.0f;
+
+  Shading();
+
+  void SetFog(SDL_Color color, float density);
+  SDL_Color GetFogColor() const { return m_FogColor; }
+  float GetFogDensity() const { return m_FogDensity; }
+
+  const FogLevel &Fog(double dist) const {
+    double step = dist * STEPS_PER_UNIT + 0.5;
+    if (!(step < (double)m_Levels.size())) // Also catches NaN
+      return m_Levels.back();
+    return m_Levels[step > 0.0 ? (int)step : 0];
+  }
+
+  // Wall modulation: side shading and fog as enabled by the material
+  SDL_Color Wall(double dist, bool sideShade, bool fog) const {
+    if (!fog) {
+      Uint8 base = sideShade ? 150 : 255;
+      return {base, base, base, 255};
+    }
+    const FogLevel &level = Fog(dist);
+    return sideShade ? level.side : level.lit;
+  }
+
+  // Global light multiplier (the ambient pulse), set once per frame
+  void SetAmbient(float ambient) { m_Ambient = ambient; }
+  float GetAmbient() const { return m_Ambient; }
+
+private:
+  void Rebuild();
+
+  std::vector<FogLevel> m_Levels;
+  SDL_Color m_FogColor = {180, 200, 220, 255}; // Match daylight sky
+  float m_FogDensity = 0.1f;
+  float m_Ambient = 1.0f;
+};
+
+} // namespace PixelsEngine
@@ -0,0 +1,161 @@
+#include "SkyPanorama.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <vector>
+
+namespace PixelsEngine {
+
+namespace {
+
+struct Rgb {
+  float r, g, b;
+};
+
+const Rgb HORIZON_SKY = {175, 218, 242};
+const Rgb ZENITH_SKY = {85, 155, 225};
+const Rgb GLOW = {200, 220, 255};
+const Rgb SUN = {255, 250, 225};
+const float SUN_YAW = 0.6f; // Looking along this yaw centres the sun
+
+Rgb Mix(const Rgb &a, const Rgb &b, float t) {
+  return {a.r + (b.r - a.r) * t, a.g + (b.g - a.g) * t,
+          a.b + (b.b - a.b) * t};
+}
+
+Uint32 Pack(const Rgb &c) {
+  return 0xFF000000u | ((Uint32)c.r << 16) | ((Uint32)c.g << 8) |
+         (Uint32)c.b;
+}
+
+} // namespace
+
+void SkyPanorama::Build(SDL_Renderer *ren, int outputWidth,
+                        int outputHeight) {
+  if (m_Texture && 2 * outputWidth == m_Period && outputHeight == m_ImageHeight)
+    return;
+  m_Period = 2 * outputWidth;
+  m_ImageHeight = outputHeight;
+
+  int P = m_Period;
+  int H = outputHeight;
+  float glowHeight = std::max(1.0f, H / 16.0f);
+  float sunRadius = std::max(2.0f, H / 40.0f);
+  float haloRadius = sunRadius * 4.0f;
+  float sunX = SUN_YAW / (2.0f * (float)M_PI) * P + outputWidth / 2;
+  float sunY = H - 1 - H / 4.0f;
+
+  std::vector<Uint32> pixels((size_t)P * H);
+  for (int y = 0; y < H; y++) {
+    // Height above the horizon row, 0..1
+    float up = H > 1 ? (float)(H - 1 - y) / (H - 1) : 0.0f;
+    Rgb row = Mix(HORIZON_SKY, ZENITH_SKY, std::sqrt(up));
+    float glow = std::max(0.0f, 1.0f - (H - 1 - y) / glowHeight);
+    row = Mix(row, GLOW, glow * glow);
+
+    float dy = y - sunY;
+    for (int x = 0; x < P; x++) {
+      float dx = std::fabs(x - sunX);
+      dx = std::min(dx, P - dx); // The panorama wraps around
+      float d = std::sqrt(dx * dx + dy * dy);
+      Rgb c = row;
+      if (d <= sunRadius) {
+        c = SUN;
+      } else if (d < haloRadius) {
+        float halo = 1.0f - (d - sunRadius) / (haloRadius - sunRadius);
+        c = Mix(row, SUN, halo * halo * 0.6f);
+      }
+      pixels[(size_t)y * P + x] = Pack(c);
+    }
+  }
+  m_Zenith = pixels[0];
+
+  m_Texture = std::make_unique<Texture>(ren, P, H, pixels.data());
+  if (m_Texture->GetSDLTexture())
+    SDL_SetTextureBlendMode(m_Texture->GetSDLTexture(), SDL_BLENDMODE_NONE);
+}
+
+int SkyPanorama::ColumnOffset(float yaw) const {
+  double offset = std::fmod(yaw / (2.0 * M_PI) * m_Period, (double)m_Period);
+  if (offset < 0)
+    offset += m_Period;
+  return std::min((int)offset, m_Period - 1);
+}
+
+void SkyPanorama::Draw(SDL_Renderer *ren, float yaw, int horizon,
+                       int viewWidth, int viewHeight) const {
+  if (!m_Texture || horizon < 0)
+    return;
+  int w = viewWidth;
+  int h = viewHeight;
+  int H = m_ImageHeight;
+  int top = horizon - (h - 1);
+  if (top > 0) {
+    SDL_SetRenderDrawColor(ren, (m_Zenith >> 16) & 0xFF, (m_Zenith >> 8) & 0xFF,
+                           m_Zenith & 0xFF, 255);
+    SDL_Rect above = {0, 0, w, top};
+    SDL_RenderFillRect(ren, &above);
+  }
+
+  // The view shows half of the panorama's columns, wrapping at most once;
+  // the renderer scales them to the view's w x h
+  int half = m_Period / 2;
+  int offset = ColumnOffset(yaw);
+  int first = std::min(half, m_Period - offset);
+  int firstW = (int)((Sint64)first * w / half);
+  SDL_Rect src = {offset, 0, first, H};
+  m_Texture->RenderRect(0, top, &src, firstW, h);
+  if (first < half) {
+    SDL_Rect rest = {0, 0, half - first, H};
+    m_Texture->RenderRect(firstW, top, &rest, w - firstW, h);
+  }
+}
+
+void SkyPanorama::DrawSoftware(Uint32 *pixels, float yaw, int horizon,
+                               int viewWidth, int viewHeight) {
+  if (!m_Texture || !m_Texture->GetPixels() || horizon < 0)
+    return;
+  int w = viewWidth;
+  int h = viewHeight;
+  int H = m_ImageHeight;
+  int half = m_Period / 2;
+  int top = horizon - (h - 1);
+  int offset = ColumnOffset(yaw);
+  const Uint32 *image = m_Texture->GetPixels();
+  int lastRow = std::min(horizon, h - 1);
+
+  if (w == half && h == H) {
+    // Full resolution: rows are straight copies
+    int first = std::min(w, m_Period - offset);
+    for (int y = 0; y <= lastRow; y++) {
+      Uint32 *dst = pixels + (size_t)y * w;
+      if (y < top) {
+        std::fill(dst, dst + w, m_Zenith);
+        continue;
+      }
+      const Uint32 *src = image + (size_t)(y - top) * m_Period;
+      std::memcpy(dst, src + offset, first * sizeof(Uint32));
+      if (first < w)
+        std::memcpy(dst + first, src, (w - first) * sizeof(Uint32));
+    }
+    return;
+  }
+
+  // Scaled view: nearest texel, with the bottom row kept on the horizon
+  m_Columns.resize(w);
+  for (int x = 0; x < w; x++)
+    m_Columns[x] = (offset + (int)((Sint64)x * half / w)) % m_Period;
+  for (int y = 0; y <= lastRow; y++) {
+    Uint32 *dst = pixels + (size_t)y * w;
+    if (y < top) {
+      std::fill(dst, dst + w, m_Zenith);
+      continue;
+    }
+    int row = H - 1 - (int)((Sint64)(horizon - y) * H / h);
+    const Uint32 *src = image + (size_t)std::max(0, row) * m_Period;
+    for (int x = 0; x < w; x++)
+      dst[x] = src[m_Columns[x]];
+  }
+}
+
+} // namespace PixelsEngine
@@ -0,0 +1,38 @@
+#pragma once
+#include "Texture.h"
+#include <SDL2/SDL.h>
+#include <memory>
+#include <vector>
+
+namespace PixelsEngine {
+
+// Pre-rendered daytime sky (gradient, sun and horizon glow) covering a full
+// turn. The image is built at output resolution: one turn spans two output
+// widths and the bottom row is the horizon. A view of any internal size
+// shows half the image's width and its full height above the horizon, so
+// drawing it is one or two (scaled) copies offset by yaw and the horizon row.
+class SkyPanorama {
+public:
+  // Regenerates the image if the output size changed; a render scale change
+  // only changes how it is sampled
+  void Build(SDL_Renderer *ren, int outputWidth, int outputHeight);
+
+  // Fills rows [0, horizon] of a viewWidth x viewHeight view. Rows above the
+  // image get the zenith colour.
+  void Draw(SDL_Renderer *ren, float yaw, int horizon, int viewWidth,
+            int viewHeight) const;
+  void DrawSoftware(Uint32 *pixels, float yaw, int horizon, int viewWidth,
+                    int viewHeight);
+
+private:
+  // First panorama column on screen for this yaw
+  int ColumnOffset(float yaw) const;
+
+  std::unique_ptr<Texture> m_Texture;
+  int m_ImageHeight = 0;
+  int m_Period = 0; // Panorama width: one full turn
+  Uint32 m_Zenith = 0;
+  std::vector<int> m_Columns; // Panorama column of each view column
+};
+
+} // namespace PixelsEngine
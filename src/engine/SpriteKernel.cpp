@@ -0,0 +1,127 @@
+#include "SpriteKernel.h"
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+namespace PixelsEngine {
+
+namespace {
+
+// Every step is written out in the same order as the vector paths below, so
+// the results match bit for bit
+inline void TransformOne(const SpriteCamera &cam, float px, float py, int i,
+                         const SpriteTransforms &out) {
+  float sx = px - cam.x;
+  float sy = py - cam.y;
+  float depth = cam.invDet * (cam.planeX * sy - cam.planeY * sx);
+  float tx = cam.invDet * (cam.dirY * sx - cam.dirX * sy);
+  out.dist[i] = sx * sx + sy * sy;
+  out.depth[i] = depth;
+  out.screenX[i] = cam.halfWidth * (1.0f + tx / depth);
+  out.projHeight[i] = cam.height / depth;
+  out.projWidth[i] = cam.widthScale / depth;
+}
+
+} // namespace
+
+void TransformSpritesScalar(const SpriteCamera &cam, const float *x,
+                            const float *y, int count,
+                            const SpriteTransforms &out) {
+  for (int i = 0; i < count; i++)
+    TransformOne(cam, x[i], y[i], i, out);
+}
+
+#if defined(__AVX2__)
+
+void TransformSprites(const SpriteCamera &cam, const float *x, const float *y,
+                      int count, const SpriteTransforms &out) {
+  const __m256 camX = _mm256_set1_ps(cam.x);
+  const __m256 camY = _mm256_set1_ps(cam.y);
+  const __m256 dirX = _mm256_set1_ps(cam.dirX);
+  const __m256 dirY = _mm256_set1_ps(cam.dirY);
+  const __m256 planeX = _mm256_set1_ps(cam.planeX);
+  const __m256 planeY = _mm256_set1_ps(cam.planeY);
+  const __m256 invDet = _mm256_set1_ps(cam.invDet);
+  const __m256 halfWidth = _mm256_set1_ps(cam.halfWidth);
+  const __m256 height = _mm256_set1_ps(cam.height);
+  const __m256 widthScale = _mm256_set1_ps(cam.widthScale);
+  const __m256 one = _mm256_set1_ps(1.0f);
+
+  int i = 0;
+  for (; i + 8 <= count; i += 8) {
+    __m256 sx = _mm256_sub_ps(_mm256_loadu_ps(x + i), camX);
+    __m256 sy = _mm256_sub_ps(_mm256_loadu_ps(y + i), camY);
+    __m256 depth = _mm256_mul_ps(
+        invDet, _mm256_sub_ps(_mm256_mul_ps(planeX, sy),
+                              _mm256_mul_ps(planeY, sx)));
+    __m256 tx = _mm256_mul_ps(
+        invDet,
+        _mm256_sub_ps(_mm256_mul_ps(dirY, sx), _mm256_mul_ps(dirX, sy)));
+    _mm256_storeu_ps(out.dist + i, _mm256_add_ps(_mm256_mul_ps(sx, sx),
+                                                 _mm256_mul_ps(sy, sy)));
+    _mm256_storeu_ps(out.depth + i, depth);
+    _mm256_storeu_ps(out.screenX + i,
+                     _mm256_mul_ps(halfWidth,
+                                   _mm256_add_ps(one, _mm256_div_ps(tx, depth))));
+    _mm256_storeu_ps(out.projHeight + i, _mm256_div_ps(height, depth));
+    _mm256_storeu_ps(out.projWidth + i, _mm256_div_ps(widthScale, depth));
+  }
+  for (; i < count; i++)
+    TransformOne(cam, x[i], y[i], i, out);
+}
+
+const char *GetSpriteKernelName() { return "AVX2"; }
+
+#elif defined(__SSE2__)
+
+void TransformSprites(const SpriteCamera &cam, const float *x, const float *y,
+                      int count, const SpriteTransforms &out) {
+  const __m128 camX = _mm_set1_ps(cam.x);
+  const __m128 camY = _mm_set1_ps(cam.y);
+  const __m128 dirX = _mm_set1_ps(cam.dirX);
+  const __m128 dirY = _mm_set1_ps(cam.dirY);
+  const __m128 planeX = _mm_set1_ps(cam.planeX);
+  const __m128 planeY = _mm_set1_ps(cam.planeY);
+  const __m128 invDet = _mm_set1_ps(cam.invDet);
+  const __m128 halfWidth = _mm_set1_ps(cam.halfWidth);
+  const __m128 height = _mm_set1_ps(cam.height);
+  const __m128 widthScale = _mm_set1_ps(cam.widthScale);
+  const __m128 one = _mm_set1_ps(1.0f);
+
+  int i = 0;
+  for (; i + 4 <= count; i += 4) {
+    __m128 sx = _mm_sub_ps(_mm_loadu_ps(x + i), camX);
+    __m128 sy = _mm_sub_ps(_mm_loadu_ps(y + i), camY);
+    __m128 depth = _mm_mul_ps(
+        invDet, _mm_sub_ps(_mm_mul_ps(planeX, sy), _mm_mul_ps(planeY, sx)));
+    __m128 tx = _mm_mul_ps(
+        invDet, _mm_sub_ps(_mm_mul_ps(dirY, sx), _mm_mul_ps(dirX, sy)));
+    _mm_storeu_ps(out.dist + i,
+                  _mm_add_ps(_mm_mul_ps(sx, sx), _mm_mul_ps(sy, sy)));
+    _mm_storeu_ps(out.depth + i, depth);
+    _mm_storeu_ps(out.screenX + i,
+                  _mm_mul_ps(halfWidth, _mm_add_ps(one, _mm_div_ps(tx, depth))));
+    _mm_storeu_ps(out.projHeight + i, _mm_div_ps(height, depth));
+    _mm_storeu_ps(out.projWidth + i, _mm_div_ps(widthScale, depth));
+  }
+  for (; i < count; i++)
+    TransformOne(cam, x[i], y[i], i, out);
+}
+
+const char *GetSpriteKernelName() { return "SSE2"; }
+
+#else
+
+void TransformSprites(const SpriteCamera &cam, const float *x, const float *y,
+                      int count, const SpriteTransforms &out) {
+  TransformSpritesScalar(cam, x, y, count, out);
+}
+
+const char *GetSpriteKernelName() { return "Scalar"; }
+
+#endif
+
+} // namespace PixelsEngine
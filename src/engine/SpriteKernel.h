@@ -0,0 +1,39 @@
+#pragma once
+
+namespace PixelsEngine {
+
+// Camera set-up shared by every sprite in a frame
+struct SpriteCamera {
+  float x, y;
+  float dirX, dirY;
+  float planeX, planeY;
+  float invDet;     // 1 / (planeX * dirY - dirX * planeY)
+  float halfWidth;  // View width / 2, rounded down like the renderer's
+  float height;     // View height in pixels
+  float widthScale; // View height * pixel aspect
+};
+
+// Per-sprite results, one array per field. Entries for sprites at or behind
+// depth 0 are not meaningful; callers test depth first.
+struct SpriteTransforms {
+  float *dist;       // Squared distance from the camera (for sorting)
+  float *depth;      // Distance along the view direction (transformY)
+  float *screenX;    // Column of the sprite centre, before truncation
+  float *projHeight; // height / depth: on-screen size of one world unit
+  float *projWidth;  // widthScale / depth
+};
+
+// Transforms `count` sprite positions given as separate x and y arrays.
+// Uses AVX2 (8 sprites per iteration) or SSE2 (4) when the build targets
+// them; the scalar path produces identical output.
+void TransformSprites(const SpriteCamera &cam, const float *x, const float *y,
+                      int count, const SpriteTransforms &out);
+
+// Reference implementation, always available
+void TransformSpritesScalar(const SpriteCamera &cam, const float *x,
+                            const float *y, int count,
+                            const SpriteTransforms &out);
+
+const char *GetSpriteKernelName();
+
+} // namespace PixelsEngine
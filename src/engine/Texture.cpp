@@ -1,5 +1,7 @@
 #include "Texture.h"
 #include <SDL2/SDL_image.h>
+#include <algorithm>
+#include <cstring>
 #include <iostream>
 
 namespace PixelsEngine {
@@ -25,6 +27,22 @@ Texture::Texture(SDL_Renderer *renderer, const std::string &path)
   m_Width = surface->w;
   m_Height = surface->h;
 
+  // Keep a CPU-side copy in a known format for the software renderer
+  SDL_Surface *converted =
+      SDL_ConvertSurfaceFormat(surface, SDL_PIXELFORMAT_ARGB8888, 0);
+  if (converted) {
+    m_Pixels.resize(m_Width * m_Height);
+    SDL_LockSurface(converted);
+    for (int y = 0; y < m_Height; y++) {
+      memcpy(&m_Pixels[y * m_Width],
+             (Uint8 *)converted->pixels + y * converted->pitch,
+             m_Width * sizeof(Uint32));
+    }
+    SDL_UnlockSurface(converted);
+    SDL_FreeSurface(converted);
+    BuildOpaqueRuns();
+  }
+
   SDL_FreeSurface(surface);
 
   if (!m_Texture) {
@@ -33,6 +51,78 @@ Texture::Texture(SDL_Renderer *renderer, const std::string &path)
   }
 }
 
+Texture::Texture(SDL_Renderer *renderer, int width, int height,
+                 const Uint32 *pixels)
+    : m_Renderer(renderer), m_Width(width), m_Height(height),
+      m_Pixels(pixels, pixels + (size_t)width * height) {
+  BuildOpaqueRuns();
+  m_Texture = SDL_CreateTexture(m_Renderer, SDL_PIXELFORMAT_ARGB8888,
+                                SDL_TEXTUREACCESS_STATIC, width, height);
+  if (!m_Texture) {
+    std::cerr << "Failed to create texture (" << width << "x" << height
+              << ") SDL_Error: " << SDL_GetError() << std::endl;
+    return;
+  }
+  SDL_UpdateTexture(m_Texture, NULL, m_Pixels.data(), width * sizeof(Uint32));
+  SDL_SetTextureBlendMode(m_Texture, SDL_BLENDMODE_BLEND);
+}
+
+void Texture::BuildOpaqueRuns() {
+  m_OpaqueRuns.clear();
+  m_RunOffsets.clear();
+  // Rows are stored in 16 bits
+  if (m_Pixels.empty() || m_Height > 0xFFFF)
+    return;
+  m_RunOffsets.reserve(m_Width + 1);
+  for (int x = 0; x < m_Width; x++) {
+    m_RunOffsets.push_back((int)m_OpaqueRuns.size());
+    int y = 0;
+    while (y < m_Height) {
+      while (y < m_Height && (m_Pixels[y * m_Width + x] >> 24) == 0)
+        y++;
+      if (y == m_Height)
+        break;
+      int start = y;
+      while (y < m_Height && (m_Pixels[y * m_Width + x] >> 24) != 0)
+        y++;
+      m_OpaqueRuns.push_back({(Uint16)start, (Uint16)y});
+    }
+  }
+  m_RunOffsets.push_back((int)m_OpaqueRuns.size());
+}
+
+Texture::Texture(int width, int height, std::vector<Uint32> pixels)
+    : m_Width(width), m_Height(height), m_Pixels(std::move(pixels)) {
+  BuildOpaqueRuns();
+}
+
+std::shared_ptr<Texture> Texture::CreateHalfSize() const {
+  if (m_Pixels.empty())
+    return nullptr;
+  int w = std::max(1, m_Width / 2);
+  int h = std::max(1, m_Height / 2);
+  std::vector<Uint32> pixels((size_t)w * h);
+  for (int y = 0; y < h; y++) {
+    int y0 = std::min(y * 2, m_Height - 1);
+    int y1 = std::min(y * 2 + 1, m_Height - 1);
+    for (int x = 0; x < w; x++) {
+      int x0 = std::min(x * 2, m_Width - 1);
+      int x1 = std::min(x * 2 + 1, m_Width - 1);
+      Uint32 block[4] = {m_Pixels[y0 * m_Width + x0], m_Pixels[y0 * m_Width + x1],
+                         m_Pixels[y1 * m_Width + x0], m_Pixels[y1 * m_Width + x1]};
+      Uint32 out = 0;
+      for (int shift = 0; shift < 32; shift += 8) {
+        Uint32 sum = 2; // Round to nearest
+        for (Uint32 c : block)
+          sum += (c >> shift) & 0xFF;
+        out |= (sum / 4) << shift;
+      }
+      pixels[y * w + x] = out;
+    }
+  }
+  return std::make_shared<Texture>(w, h, std::move(pixels));
+}
+
 Texture::~Texture() {
   if (m_Texture) {
     SDL_DestroyTexture(m_Texture);
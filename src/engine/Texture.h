@@ -1,12 +1,25 @@
 #pragma once
 #include <SDL2/SDL.h>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace PixelsEngine {
 
 class Texture {
 public:
+  // Rows [start, end) of one column whose texels are not fully transparent
+  struct OpaqueRun {
+    Uint16 start;
+    Uint16 end;
+  };
+
   Texture(SDL_Renderer *renderer, const std::string &path);
+  // Creates a static texture from ARGB8888 pixels (e.g. an atlas page)
+  Texture(SDL_Renderer *renderer, int width, int height, const Uint32 *pixels);
+  // CPU-only image with no SDL texture, for pixels that are only ever drawn
+  // from an atlas page (e.g. mip levels)
+  Texture(int width, int height, std::vector<Uint32> pixels);
   ~Texture();
 
   void Render(int x, int y, int w = -1, int h = -1) const;
@@ -17,12 +30,42 @@ public:
 
   int GetWidth() const { return m_Width; }
   int GetHeight() const { return m_Height; }
+  SDL_Texture *GetSDLTexture() const { return m_Texture; }
+
+  // Half-size CPU-only copy, each texel the average of a 2x2 block. Odd
+  // sizes round down (never below 1). Returns nullptr without pixels.
+  std::shared_ptr<Texture> CreateHalfSize() const;
+
+  // CPU copy of the image in ARGB8888, row-major (used by the software
+  // renderer). Empty if the image failed to load.
+  const Uint32 *GetPixels() const {
+    return m_Pixels.empty() ? nullptr : m_Pixels.data();
+  }
+
+  // Opaque runs of column x, top to bottom, found when the pixels load so
+  // the software renderer can skip transparent texels. Fully transparent
+  // columns have no runs.
+  const OpaqueRun *GetOpaqueRuns(int x, int &count) const {
+    if (m_RunOffsets.empty()) {
+      count = 0;
+      return nullptr;
+    }
+    count = m_RunOffsets[x + 1] - m_RunOffsets[x];
+    return m_OpaqueRuns.data() + m_RunOffsets[x];
+  }
 
 private:
   SDL_Renderer *m_Renderer = nullptr;
   SDL_Texture *m_Texture = nullptr;
   int m_Width = 0;
   int m_Height = 0;
+  std::vector<Uint32> m_Pixels;
+  // Runs of every column back to back; column x owns
+  // [m_RunOffsets[x], m_RunOffsets[x + 1])
+  std::vector<OpaqueRun> m_OpaqueRuns;
+  std::vector<int> m_RunOffsets;
+
+  void BuildOpaqueRuns();
 };
 
 } // namespace PixelsEngine
@@ -0,0 +1,111 @@
+#include "TextureAtlas.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace PixelsEngine {
+
+int TextureAtlas::Add(const std::shared_ptr<Texture> &texture) {
+  auto it = m_Lookup.find(texture.get());
+  if (it != m_Lookup.end())
+    return it->second;
+  int id = (int)m_Sources.size();
+  m_Sources.push_back(texture);
+  m_Regions.push_back(AtlasRegion());
+  m_Lookup[texture.get()] = id;
+  m_Dirty = true;
+  return id;
+}
+
+const AtlasRegion *TextureAtlas::Find(const Texture *texture) const {
+  auto it = m_Lookup.find(texture);
+  if (it == m_Lookup.end() || !m_Regions[it->second].IsValid())
+    return nullptr;
+  return &m_Regions[it->second];
+}
+
+void TextureAtlas::Build(SDL_Renderer *renderer) {
+  // Shelf packing, tallest images first
+  std::vector<int> order;
+  for (int i = 0; i < (int)m_Sources.size(); i++) {
+    if (m_Sources[i] && m_Sources[i]->GetPixels())
+      order.push_back(i);
+  }
+  std::sort(order.begin(), order.end(), [this](int a, int b) {
+    return m_Sources[a]->GetHeight() > m_Sources[b]->GetHeight();
+  });
+
+  struct PageLayout {
+    int width = 0, height = 0;
+    int shelfX = 0, shelfY = 0, shelfH = 0;
+    std::vector<int> images;
+  };
+  std::vector<PageLayout> layouts;
+  int shelfPage = -1; // The page new images are packed onto
+
+  for (int id : order) {
+    int w = m_Sources[id]->GetWidth() + PADDING;
+    int h = m_Sources[id]->GetHeight() + PADDING;
+
+    // Images that cannot share a page get one of their own, sized to fit;
+    // shelf packing carries on in the current page
+    if (w > PAGE_SIZE || h > PAGE_SIZE) {
+      std::cerr << "TextureAtlas: " << w - PADDING << "x" << h - PADDING
+                << " image does not fit a shared " << PAGE_SIZE
+                << " page; giving it its own" << std::endl;
+      PageLayout layout;
+      layout.width = w - PADDING;
+      layout.height = h - PADDING;
+      layout.images.push_back(id);
+      layouts.push_back(layout);
+      AtlasRegion &region = m_Regions[id];
+      region.page = (int)layouts.size() - 1;
+      region.rect = {0, 0, w - PADDING, h - PADDING};
+      continue;
+    }
+
+    PageLayout *page = shelfPage < 0 ? nullptr : &layouts[shelfPage];
+    if (page && page->shelfX + w > PAGE_SIZE) {
+      page->shelfY += page->shelfH;
+      page->shelfX = 0;
+      page->shelfH = 0;
+    }
+    if (!page || page->shelfY + h > PAGE_SIZE) {
+      layouts.push_back(PageLayout());
+      shelfPage = (int)layouts.size() - 1;
+      page = &layouts.back();
+    }
+
+    AtlasRegion &region = m_Regions[id];
+    region.page = shelfPage;
+    region.rect = {page->shelfX, page->shelfY, w - PADDING, h - PADDING};
+    page->shelfX += w;
+    page->shelfH = std::max(page->shelfH, h);
+    page->width = std::max(page->width, page->shelfX);
+    page->height = std::max(page->height, page->shelfY + page->shelfH);
+    page->images.push_back(id);
+  }
+
+  m_Pages.clear();
+  for (int p = 0; p < (int)layouts.size(); p++) {
+    const PageLayout &layout = layouts[p];
+    std::vector<Uint32> pixels((size_t)layout.width * layout.height, 0);
+    for (int id : layout.images) {
+      AtlasRegion &region = m_Regions[id];
+      const Uint32 *src = m_Sources[id]->GetPixels();
+      for (int y = 0; y < region.rect.h; y++) {
+        memcpy(&pixels[(size_t)(region.rect.y + y) * layout.width + region.rect.x],
+               src + y * region.rect.w, region.rect.w * sizeof(Uint32));
+      }
+      region.u0 = (float)region.rect.x / layout.width;
+      region.v0 = (float)region.rect.y / layout.height;
+      region.u1 = (float)(region.rect.x + region.rect.w) / layout.width;
+      region.v1 = (float)(region.rect.y + region.rect.h) / layout.height;
+    }
+    m_Pages.push_back(std::make_unique<Texture>(renderer, layout.width,
+                                                layout.height, pixels.data()));
+  }
+  m_Dirty = false;
+}
+
+} // namespace PixelsEngine
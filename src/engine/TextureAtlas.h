@@ -0,0 +1,71 @@
+#pragma once
+#include "Texture.h"
+#include <SDL2/SDL.h>
+#include <array>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+namespace PixelsEngine {
+
+// Where an image lives inside an atlas page, in pixels and normalized UVs
+struct AtlasRegion {
+  int page = -1;
+  SDL_Rect rect = {0, 0, 0, 0};
+  float u0 = 0.0f, v0 = 0.0f, u1 = 0.0f, v1 = 0.0f;
+
+  bool IsValid() const { return page >= 0; }
+};
+
+enum MaterialFlags : Uint8 {
+  MAT_SIDE_SHADE = 1 << 0, // Y-facing sides are drawn darker
+  MAT_FOG = 1 << 1,        // Blends towards the fog colour with distance
+};
+
+// Wall images keep up to this many mip levels, each half the size of the
+// one before
+const int MAX_WALL_MIPS = 8;
+
+// How a tile ID looks. What it does (blocks rays, runnable, ...) lives in
+// the Map's tile flags.
+struct Material {
+  AtlasRegion wall;
+  // wallMips[0] is `wall`; levels past wallMipCount are invalid
+  std::array<AtlasRegion, MAX_WALL_MIPS> wallMips;
+  int wallMipCount = 0;
+  AtlasRegion floor;
+  Uint8 flags = 0;
+};
+
+// Packs many small images into a few large pages so renderers can draw them
+// without switching textures. Images are added as already loaded Textures
+// (their CPU pixel copies are packed); Build() creates the page textures.
+// An image that does not fit within PAGE_SIZE gets a page of its own, sized
+// to the image, so every region still lives on some page.
+class TextureAtlas {
+public:
+  static const int PAGE_SIZE = 1024;
+  static const int PADDING = 1;
+
+  // Returns the region ID for the texture, adding it if needed
+  int Add(const std::shared_ptr<Texture> &texture);
+
+  // Packs everything added so far into pages. Region IDs stay valid.
+  void Build(SDL_Renderer *renderer);
+  bool IsDirty() const { return m_Dirty; }
+
+  const AtlasRegion &GetRegion(int id) const { return m_Regions[id]; }
+  const AtlasRegion *Find(const Texture *texture) const;
+
+  int GetPageCount() const { return (int)m_Pages.size(); }
+  Texture *GetPage(int page) const { return m_Pages[page].get(); }
+
+private:
+  std::vector<std::shared_ptr<Texture>> m_Sources;
+  std::vector<AtlasRegion> m_Regions;
+  std::unordered_map<const Texture *, int> m_Lookup;
+  std::vector<std::unique_ptr<Texture>> m_Pages;
+  bool m_Dirty = false;
+};
+
+} // namespace PixelsEngine
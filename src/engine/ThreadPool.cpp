@@ -0,0 +1,87 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+namespace PixelsEngine {
+
+ThreadPool::ThreadPool(int workerCount) {
+#if defined(__EMSCRIPTEN__) && !defined(__EMSCRIPTEN_PTHREADS__)
+  workerCount = 0;
+#else
+  if (workerCount < 0)
+    workerCount = std::max(0, (int)std::thread::hardware_concurrency() - 1);
+#endif
+  for (int i = 0; i < workerCount; i++)
+    m_Workers.emplace_back(&ThreadPool::WorkerLoop, this);
+}
+
+ThreadPool::~ThreadPool() {
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Stop = true;
+  }
+  m_WorkCv.notify_all();
+  for (auto &worker : m_Workers)
+    worker.join();
+}
+
+void ThreadPool::ParallelFor(int count, int grain,
+                             const std::function<void(int, int)> &fn) {
+  if (count <= 0)
+    return;
+  grain = std::max(1, grain);
+  if (m_Workers.empty() || count <= grain) {
+    fn(0, count);
+    return;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(m_Mutex);
+    m_Job = &fn;
+    m_Count = count;
+    m_Grain = grain;
+    m_NextIndex.store(0);
+    m_BusyWorkers = (int)m_Workers.size();
+    m_Generation++;
+  }
+  m_WorkCv.notify_all();
+
+  RunChunks();
+
+  std::unique_lock<std::mutex> lock(m_Mutex);
+  m_DoneCv.wait(lock, [this] { return m_BusyWorkers == 0; });
+  m_Job = nullptr;
+}
+
+void ThreadPool::RunChunks() {
+  while (true) {
+    int begin = m_NextIndex.fetch_add(m_Grain);
+    if (begin >= m_Count)
+      break;
+    (*m_Job)(begin, std::min(m_Count, begin + m_Grain));
+  }
+}
+
+void ThreadPool::WorkerLoop() {
+  unsigned seenGeneration = 0;
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock(m_Mutex);
+      m_WorkCv.wait(lock, [&] {
+        return m_Stop || m_Generation != seenGeneration;
+      });
+      if (m_Stop)
+        return;
+      seenGeneration = m_Generation;
+    }
+
+    RunChunks();
+
+    {
+      std::lock_guard<std::mutex> lock(m_Mutex);
+      m_BusyWorkers--;
+    }
+    m_DoneCv.notify_one();
+  }
+}
+
+} // namespace PixelsEngine
@@ -0,0 +1,50 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace PixelsEngine {
+
+// Persistent worker pool for data-parallel loops. The calling thread takes
+// part in every job, so a pool with zero workers simply runs inline (this is
+// what happens on single-core machines and Emscripten builds without
+// pthreads).
+class ThreadPool {
+public:
+  // workerCount < 0 picks hardware_concurrency() - 1
+  explicit ThreadPool(int workerCount = -1);
+  ~ThreadPool();
+
+  ThreadPool(const ThreadPool &) = delete;
+  ThreadPool &operator=(const ThreadPool &) = delete;
+
+  // Total threads that execute a job (workers + caller)
+  int GetThreadCount() const { return (int)m_Workers.size() + 1; }
+
+  // Calls fn(begin, end) over [0, count) in chunks of `grain` items and
+  // blocks until every chunk has finished.
+  void ParallelFor(int count, int grain,
+                   const std::function<void(int, int)> &fn);
+
+private:
+  void WorkerLoop();
+  void RunChunks();
+
+  std::vector<std::thread> m_Workers;
+  std::mutex m_Mutex;
+  std::condition_variable m_WorkCv;
+  std::condition_variable m_DoneCv;
+
+  const std::function<void(int, int)> *m_Job = nullptr;
+  int m_Count = 0;
+  int m_Grain = 1;
+  std::atomic<int> m_NextIndex{0};
+  int m_BusyWorkers = 0;
+  unsigned m_Generation = 0;
+  bool m_Stop = false;
+};
+
+} // namespace PixelsEngine
@@ -0,0 +1,219 @@
+#include "WallKernel.h"
+#include <algorithm>
+#include <array>
+#include <string>
+#include <utility>
+
+namespace PixelsEngine {
+
+namespace {
+
+inline Uint32 PackRGB(int r, int g, int b) {
+  return 0xFF000000u | ((Uint32)r << 16) | ((Uint32)g << 8) | (Uint32)b;
+}
+
+// Smallest mip level that still has a row for every screen pixel of a wall
+// lineHeight pixels tall
+inline const WallImage &SelectMip(const WallMaterial &mat, int lineHeight) {
+  int level = 0;
+  while (level + 1 < mat.mipCount && mat.mips[level + 1].height >= lineHeight)
+    level++;
+  return mat.mips[level];
+}
+
+inline int ColumnHorizon(const WallFrame &f, int x) {
+  float rollOffset = (x - f.width / 2) * (f.roll * 0.02f);
+  return f.height / 2 + f.pitch + (int)rollOffset;
+}
+
+// Rows [from, to) of one column. texPos carries on from the previous span
+// so splitting a column into spans does not change which texels it reads.
+template <bool Shade, bool Dark>
+inline void DrawSpan(Uint32 *dst, int width, const Uint32 *texels, int pitch,
+                     int texH, double step, double &texPos, int from, int to,
+                     SDL_Color mod) {
+  for (int y = from; y < to; y++) {
+    int texY = std::min(texH - 1, (int)texPos);
+    texPos += step;
+    Uint32 c = texels[texY * pitch];
+    int r = (c >> 16) & 0xFF;
+    int g = (c >> 8) & 0xFF;
+    int b = c & 0xFF;
+    if (Shade) {
+      r = r * mod.r / 255;
+      g = g * mod.g / 255;
+      b = b * mod.b / 255;
+    }
+    if (Dark) {
+      r = r * 100 / 255;
+      g = g * 100 / 255;
+      b = b * 100 / 255;
+    }
+    dst[y * width] = PackRGB(r, g, b);
+  }
+}
+
+template <unsigned Features>
+void DrawWallColumns(const WallFrame &f, int begin, int end) {
+  constexpr bool roll = (Features & WALL_ROLL) != 0;
+  constexpr bool shade = (Features & WALL_SHADE) != 0;
+  constexpr bool mips = (Features & WALL_MIPS) != 0;
+  constexpr bool oneMaterial = (Features & WALL_ONE_MATERIAL) != 0;
+  if (begin >= end)
+    return;
+
+  int w = f.width;
+  int h = f.height;
+  int flatHorizon = h / 2 + f.pitch;
+  const WallMaterial *only = oneMaterial ? &f.materials[f.tile[begin]] : nullptr;
+  if (oneMaterial && only->mipCount == 0)
+    return;
+
+  for (int x = begin; x < end; x++) {
+    double perpWallDist = f.dist[x];
+    int lineHeight = (int)(h / perpWallDist);
+    int horizon = roll ? ColumnHorizon(f, x) : flatHorizon;
+    int drawStart = horizon - (int)((1.0f - f.camZ) * lineHeight);
+    int drawEnd = horizon + (int)(f.camZ * lineHeight);
+    if (drawEnd <= drawStart)
+      continue;
+
+    const WallMaterial &mat = oneMaterial ? *only : f.materials[f.tile[x]];
+    if (!oneMaterial && mat.mipCount == 0)
+      continue;
+    const WallImage &image = mips ? SelectMip(mat, lineHeight) : mat.mips[0];
+    int texX = mips ? f.texX[x] * image.width / mat.mips[0].width : f.texX[x];
+    const Uint32 *texels = image.texels + texX;
+
+    SDL_Color mod = {255, 255, 255, 255};
+    if (shade)
+      mod = f.shading->Wall(perpWallDist,
+                            f.side[x] == 1 && (mat.flags & MAT_SIDE_SHADE),
+                            (mat.flags & MAT_FOG) != 0);
+
+    int y0 = std::max(0, drawStart);
+    int y1 = std::min(h, drawEnd);
+    double step = (double)image.height / (drawEnd - drawStart);
+    double texPos = (y0 - drawStart) * step;
+    Uint32 *dst = f.pixels + x;
+    // The AO rows are the only ones that need the extra darkening, so the
+    // column splits into three spans instead of testing every row
+    int top = std::max(y0, std::min(drawStart + 2, y1));
+    int bottom = std::max(top, std::min(drawEnd - 2, y1));
+    DrawSpan<shade, true>(dst, w, texels, image.pitch, image.height, step,
+                          texPos, y0, top, mod);
+    DrawSpan<shade, false>(dst, w, texels, image.pitch, image.height, step,
+                           texPos, top, bottom, mod);
+    DrawSpan<shade, true>(dst, w, texels, image.pitch, image.height, step,
+                          texPos, bottom, y1, mod);
+  }
+}
+
+template <unsigned... Features>
+std::array<WallKernel, sizeof...(Features)>
+MakeWallKernels(std::integer_sequence<unsigned, Features...>) {
+  return {{&DrawWallColumns<Features>...}};
+}
+
+const std::array<WallKernel, WALL_VARIANTS> WALL_KERNELS =
+    MakeWallKernels(std::make_integer_sequence<unsigned, WALL_VARIANTS>());
+
+} // namespace
+
+unsigned GetWallFeatures(const WallFrame &f) {
+  unsigned features = 0;
+  if (f.roll != 0.0f)
+    features |= WALL_ROLL;
+
+  bool one = true;
+  const WallMaterial *first = nullptr;
+  for (int x = 0; x < f.width; x++) {
+    const WallMaterial &mat = f.materials[f.tile[x]];
+    if (!first)
+      first = &mat;
+    else if (&mat != first)
+      one = false;
+    if (mat.flags & MAT_FOG)
+      features |= WALL_SHADE;
+    else if ((mat.flags & MAT_SIDE_SHADE) && f.side[x] == 1)
+      features |= WALL_SHADE;
+    if (f.mipmaps && mat.mipCount > 1)
+      features |= WALL_MIPS;
+  }
+  if (one && first)
+    features |= WALL_ONE_MATERIAL;
+  return features;
+}
+
+WallKernel SelectWallKernel(unsigned features) {
+  return WALL_KERNELS[features & (WALL_VARIANTS - 1)];
+}
+
+void DrawWallColumnsGeneric(const WallFrame &f, int begin, int end) {
+  int w = f.width;
+  int h = f.height;
+  for (int x = begin; x < end; x++) {
+    double perpWallDist = f.dist[x];
+    int lineHeight = (int)(h / perpWallDist);
+    int horizon = ColumnHorizon(f, x);
+    int drawStart = horizon - (int)((1.0f - f.camZ) * lineHeight);
+    int drawEnd = horizon + (int)(f.camZ * lineHeight);
+    if (drawEnd <= drawStart)
+      continue;
+
+    const WallMaterial &mat = f.materials[f.tile[x]];
+    if (mat.mipCount == 0)
+      continue;
+    const WallImage &image = f.mipmaps ? SelectMip(mat, lineHeight) : mat.mips[0];
+    int texH = image.height;
+    int texX = f.texX[x] * image.width / mat.mips[0].width;
+    const Uint32 *texels = image.texels + texX;
+
+    // Side shading + distance fog folded into one colour modulation
+    SDL_Color mod = f.shading->Wall(
+        perpWallDist, f.side[x] == 1 && (mat.flags & MAT_SIDE_SHADE),
+        (mat.flags & MAT_FOG) != 0);
+
+    int y0 = std::max(0, drawStart);
+    int y1 = std::min(h, drawEnd);
+    double step = (double)texH / (drawEnd - drawStart);
+    double texPos = (y0 - drawStart) * step;
+    for (int y = y0; y < y1; y++) {
+      int texY = std::min(texH - 1, (int)texPos);
+      texPos += step;
+      Uint32 c = texels[texY * image.pitch];
+      int r = ((c >> 16) & 0xFF) * mod.r / 255;
+      int g = ((c >> 8) & 0xFF) * mod.g / 255;
+      int b = (c & 0xFF) * mod.b / 255;
+      // Fake AO: darken the two rows at the top and bottom of the wall
+      if (y < drawStart + 2 || y >= drawEnd - 2) {
+        r = r * 100 / 255;
+        g = g * 100 / 255;
+        b = b * 100 / 255;
+      }
+      f.pixels[y * w + x] = PackRGB(r, g, b);
+    }
+  }
+}
+
+const char *GetWallFeatureName(unsigned features) {
+  static const std::array<std::string, WALL_VARIANTS> names = [] {
+    const char *parts[] = {"roll", "shade", "mips", "one material"};
+    std::array<std::string, WALL_VARIANTS> out;
+    for (unsigned f = 0; f < WALL_VARIANTS; f++) {
+      for (unsigned bit = 0; bit < 4; bit++) {
+        if (!(f & (1u << bit)))
+          continue;
+        if (!out[f].empty())
+          out[f] += "+";
+        out[f] += parts[bit];
+      }
+      if (out[f].empty())
+        out[f] = "plain";
+    }
+    return out;
+  }();
+  return names[features & (WALL_VARIANTS - 1)].c_str();
+}
+
+} // namespace PixelsEngine
@@ -0,0 +1,67 @@
+#pragma once
+#include "Shading.h"
+#include "TextureAtlas.h"
+#include <SDL2/SDL.h>
+
+namespace PixelsEngine {
+
+// One mip level of a wall image, as the software rasterizer reads it
+struct WallImage {
+  const Uint32 *texels = nullptr; // Top-left texel inside the atlas page
+  int pitch = 0;                  // Texels from one row to the next
+  int width = 0;
+  int height = 0;
+};
+
+// A tile's wall images resolved out of the atlas pages
+struct WallMaterial {
+  WallImage mips[MAX_WALL_MIPS]; // mips[0] is full size
+  int mipCount = 0;              // 0 = nothing to draw
+  Uint8 flags = 0;               // MaterialFlags
+};
+
+// Everything the software wall pass reads for one frame
+struct WallFrame {
+  Uint32 *pixels = nullptr; // width x height, ARGB8888
+  int width = 0;
+  int height = 0;
+  // Per-column hits from the wall cast
+  const double *dist = nullptr;
+  const Uint8 *side = nullptr;
+  const int *texX = nullptr;
+  const int *tile = nullptr;
+  const WallMaterial *materials = nullptr; // Indexed by tile
+  const Shading *shading = nullptr;
+  int pitch = 0; // Camera pitch in whole pixels
+  float camZ = 0.5f;
+  float roll = 0.0f;
+  bool mipmaps = true;
+};
+
+// What a frame needs from the column loop. Each combination has its own
+// kernel with the unused work compiled out.
+enum WallFeature : unsigned {
+  WALL_ROLL = 1 << 0,         // The horizon tilts across the view
+  WALL_SHADE = 1 << 1,        // Some column is side shaded or fogged
+  WALL_MIPS = 1 << 2,         // Some material has more than one mip level
+  WALL_ONE_MATERIAL = 1 << 3, // Every column shows the same material
+  WALL_VARIANTS = 1 << 4,
+};
+
+// Scans the frame's columns once to find the features it needs
+unsigned GetWallFeatures(const WallFrame &frame);
+
+// Rasterizes columns [begin, end)
+using WallKernel = void (*)(const WallFrame &frame, int begin, int end);
+
+// The kernel compiled for `features`. Every kernel writes exactly the
+// pixels DrawWallColumnsGeneric does for a frame with those features.
+WallKernel SelectWallKernel(unsigned features);
+
+// Reference implementation that tests every feature per column and pixel
+void DrawWallColumnsGeneric(const WallFrame &frame, int begin, int end);
+
+// Short name of a feature set for the stats overlay, e.g. "roll+shade+mips"
+const char *GetWallFeatureName(unsigned features);
+
+} // namespace PixelsEngine
@@ -1,4 +1,5 @@
 #include "../engine/Components.h"
+#include "../engine/MapVisibility.h"
 #include "../engine/TextureManager.h"
 #include "JumpShootGame.h"
 #include <SDL2/SDL.h>
@@ -30,6 +31,17 @@ void JumpShootGame::OnStart() {
   m_BowDraw = TextureManager::LoadTexture(m_Renderer, "assets/bow_draw.png");
   m_Crosshair = TextureManager::LoadTexture(m_Renderer, "assets/crosshair.png");
 
+  // Wall/floor materials and billboards share one texture atlas
+  m_Raycaster.LoadTexture(1, "assets/wall_brick.png");
+  m_Raycaster.LoadTexture(2, "assets/wall_mossy.png");
+  m_Raycaster.LoadFloorTexture(0, "assets/floor_grass.png");
+  m_Raycaster.AddSpriteTexture(m_BowIdle);
+  m_Raycaster.AddSpriteTexture(m_BowDraw);
+  m_Raycaster.AddSpriteTexture(
+      TextureManager::LoadTexture(m_Renderer, "assets/target.png"));
+  m_Raycaster.AddSpriteTexture(
+      TextureManager::LoadTexture(m_Renderer, "assets/target_broken.png"));
+
   m_SfxShoot = Mix_LoadWAV("assets/shoot.wav");
   m_SfxHit = Mix_LoadWAV("assets/hit.wav");
   m_SfxJump = Mix_LoadWAV("assets/jump.wav");
@@ -62,8 +74,19 @@ void JumpShootGame::InitGame() {
   if (!m_Map.LoadFromFile(mapPath)) {
     // Fallback generation (only useful for level 1 really)
     for (int i = 0; i < Map::WIDTH * Map::HEIGHT; i++)
-      m_Map.tiles[i] = 0;
+      m_Map.Set(i % Map::WIDTH, i / Map::WIDTH, 0);
     // ... (simplified fallback)
+    BuildMapVisibility(m_Map);
+  } else {
+    // Which cells can see which: cached in the user's pref directory after
+    // the first run, since the assets folder may not be writable
+    std::string cachePath;
+    if (char *prefPath = SDL_GetPrefPath("woodRock", "jump-shoot")) {
+      cachePath = std::string(prefPath) +
+                  mapPath.substr(mapPath.find_last_of("/\\") + 1) + ".pvs";
+      SDL_free(prefPath);
+    }
+    LoadOrBuildMapVisibility(m_Map, cachePath);
   }
 
   // Player Setup (Same for all levels for now)
@@ -231,7 +231,7 @@ void JumpShootGame::HandleInputMenu() {
 
   bool action = false;
 
-  int numButtons = m_InOptions ? 2 : 3;
+  int numButtons = 3; // Both the main menu and its options have three
 
   // Mouse Interaction
   for (int i = 0; i < numButtons; i++) {
@@ -284,7 +284,9 @@ void JumpShootGame::HandleInputMenu() {
     } else {
       if (m_MenuSelection == 0) { // Toggle FS
         ToggleFullScreen();
-      } else if (m_MenuSelection == 1) { // Back
+      } else if (m_MenuSelection == 1) { // Toggle film effects
+        m_FilmEffects = !m_FilmEffects;
+      } else if (m_MenuSelection == 2) { // Back
         m_InOptions = false;
         m_MenuSelection = 1;
       }
@@ -317,7 +319,7 @@ void JumpShootGame::HandleInputPause() {
 
   bool action = false;
 
-  int numButtons = m_InOptions ? 2 : 4;
+  int numButtons = m_InOptions ? 3 : 4;
 
   // Mouse Interaction
   for (int i = 0; i < numButtons; i++) {
@@ -372,10 +374,44 @@ void JumpShootGame::HandleInputPause() {
     } else {
       if (m_MenuSelection == 0) { // Toggle FS
         ToggleFullScreen();
-      } else if (m_MenuSelection == 1) { // Back
+      } else if (m_MenuSelection == 1) { // Toggle film effects
+        m_FilmEffects = !m_FilmEffects;
+      } else if (m_MenuSelection == 2) { // Back
         m_InOptions = false;
         m_MenuSelection = 1;
       }
     }
   }
 }
+
+void JumpShootGame::HandleInputDebug() {
+  // Renderer comparison keys work in every game state
+  if (Input::IsKeyPressed(SDL_SCANCODE_F2)) {
+    RenderBackend next = m_Raycaster.GetBackend() == RenderBackend::Software
+                             ? RenderBackend::SDLRenderer
+                             : RenderBackend::Software;
+    m_Raycaster.SetBackend(next);
+  }
+  if (Input::IsKeyPressed(SDL_SCANCODE_F3))
+    m_ShowRenderStats = !m_ShowRenderStats;
+  if (Input::IsKeyPressed(SDL_SCANCODE_F4))
+    m_Raycaster.SetThreadedWalls(!m_Raycaster.IsThreadedWalls());
+  if (Input::IsKeyPressed(SDL_SCANCODE_F5))
+    m_Raycaster.SetBatchedWalls(!m_Raycaster.IsBatchedWalls());
+  if (Input::IsKeyPressed(SDL_SCANCODE_F6)) {
+    // Scalar -> Packet -> DistanceField -> Scalar
+    int next = ((int)m_Raycaster.GetRayTraversal() + 1) % 3;
+    m_Raycaster.SetRayTraversal((RayTraversal)next);
+  }
+  if (Input::IsKeyPressed(SDL_SCANCODE_F7)) {
+    m_AutoResolution = !m_AutoResolution;
+    m_ResolutionController.Reset();
+    m_Raycaster.SetRenderScale(1.0f, 1.0f);
+  }
+  if (Input::IsKeyPressed(SDL_SCANCODE_F8))
+    m_Raycaster.SetWallMipmaps(!m_Raycaster.IsWallMipmaps());
+  if (Input::IsKeyPressed(SDL_SCANCODE_F9))
+    m_Raycaster.SetTexturedFloor(!m_Raycaster.IsTexturedFloor());
+  if (Input::IsKeyPressed(SDL_SCANCODE_F10))
+    m_Raycaster.SetAdaptiveColumns(!m_Raycaster.IsAdaptiveColumns());
+}
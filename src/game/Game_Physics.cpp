@@ -106,11 +106,9 @@ void JumpShootGame::UpdatePhysics(float dt) {
 
     
 
-            // Assuming tile 2 is the only runnable wall (Mossy)
+            bool wallLeft = m_Map.IsRunnable((int)leftX, (int)leftY);
 
-            bool wallLeft = (m_Map.Get((int)leftX, (int)leftY) == 2);
-
-            bool wallRight = (m_Map.Get((int)rightX, (int)rightY) == 2);
+            bool wallRight = m_Map.IsRunnable((int)rightX, (int)rightY);
 
             
 
@@ -158,10 +156,11 @@ void JumpShootGame::UpdatePhysics(float dt) {
     // Floor collision & Jump Pads & Lava
 
     if (t->z < eyeHeight) {
-      int tile = m_Map.Get((int)t->x, (int)t->y);
+      int cellX = (int)t->x;
+      int cellY = (int)t->y;
 
-      // Gap (Tile 4) - Fall through
-      if (tile == 4) {
+      // Gap - Fall through
+      if (m_Map.IsAbyss(cellX, cellY)) {
           phys->isGrounded = false;
       }
       else {
@@ -186,7 +185,7 @@ void JumpShootGame::UpdatePhysics(float dt) {
             }
           }
 
-          if (tile == 3) { // Jump Pad
+          if (m_Map.IsJumpPad(cellX, cellY)) {
             phys->velZ = 12.0f;
             phys->isGrounded = false;
             if (m_SfxJump)
@@ -200,7 +199,7 @@ void JumpShootGame::UpdatePhysics(float dt) {
             }
             phys->isGrounded = true;
             // Save Checkpoint if on normal floor
-            if (tile == 0) {
+            if (!m_Map.BlocksRay(cellX, cellY)) {
               auto *ctrl =
                   m_Registry.GetComponent<PlayerControlComponent>(m_PlayerEntity);
               ctrl->spawnX = t->x;
@@ -233,10 +232,10 @@ void JumpShootGame::UpdatePhysics(float dt) {
 
     // X Axis
     t->x += phys->velX * dt;
-    int tileX = m_Map.Get((int)t->x, (int)t->y);
-    if (tileX == 1 || tileX == 2) {
+    if (m_Map.BlocksRay((int)t->x, (int)t->y)) {
+        bool runnable = m_Map.IsRunnable((int)t->x, (int)t->y);
         t->x -= phys->velX * dt;
-        if (tileX == 2 && !phys->isGrounded) {
+        if (runnable && !phys->isGrounded) {
              phys->velX = 0; // Slide along wall
         } else {
              phys->velX *= -0.5f;
@@ -245,10 +244,10 @@ void JumpShootGame::UpdatePhysics(float dt) {
 
     // Y Axis
     t->y += phys->velY * dt;
-    int tileY = m_Map.Get((int)t->x, (int)t->y);
-    if (tileY == 1 || tileY == 2) {
+    if (m_Map.BlocksRay((int)t->x, (int)t->y)) {
+        bool runnable = m_Map.IsRunnable((int)t->x, (int)t->y);
         t->y -= phys->velY * dt;
-        if (tileY == 2 && !phys->isGrounded) {
+        if (runnable && !phys->isGrounded) {
              phys->velY = 0; // Slide along wall
         } else {
              phys->velY *= -0.5f;
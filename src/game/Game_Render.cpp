@@ -1,10 +1,45 @@
 #include "../engine/Components.h"
 #include "JumpShootGame.h"
+#include <algorithm>
 #include <cmath>
 
 using namespace PixelsEngine;
 
 void JumpShootGame::OnRender() {
+  // Size the 3D view from how long the last frame took
+  if (m_AutoResolution) {
+    m_ResolutionController.Update(GetFrameWorkMs());
+    float scale = m_ResolutionController.GetScale();
+    m_Raycaster.SetRenderScale(scale, scale);
+  }
+
+  // Screen effects for this state, applied by the raycaster in one pass
+  PostEffects effects;
+  if (m_State == GameState::MainMenu) {
+    // Film look behind the title, when turned on in the options
+    if (m_FilmEffects) {
+      effects.scanlines = 24;
+      effects.grain = 10;
+    }
+  } else if (m_State == GameState::Playing) {
+    // Grapple Rope: over the vignette, under the slow-mo wash
+    if (m_IsGrappling) {
+      effects.overlay = {m_Width / 2, m_Height / 2, 1,
+                         m_Height - m_Height / 2};
+      effects.overlayColor = {150, 150, 150, 255};
+    }
+    // Slow-mo Visual Cue: blue wash with a brighter centre
+    if (m_TimeScale < 1.0f) {
+      effects.tint = {0, 50, 150, 40};
+      effects.focus = {255, 255, 255, 10};
+    }
+    // Warm flash that fades with the hitmarker
+    if (m_HitmarkerTimer > 0.0f)
+      effects.flash = {255, 240, 200,
+                       (Uint8)(std::min(1.0f, m_HitmarkerTimer / 0.15f) * 50)};
+  }
+  m_Raycaster.SetPostEffects(effects);
+
   if (m_State == GameState::MainMenu) {
     // Draw 3D Background
     // Use a rotating camera
@@ -19,41 +54,18 @@ void JumpShootGame::OnRender() {
 
     RenderMainMenu();
   } else if (m_State == GameState::Playing) {
-    int w = m_Width;
-    int h = m_Height;
-
     // Apply Bobbing to Camera z temporarily for render
     Camera bobCam = *m_Camera;
     float bobOffset = sin(m_BobTimer) * 0.05f;
     bobCam.z += bobOffset;
 
     m_Raycaster.Render(m_Renderer, bobCam, m_Map, m_Registry, m_CameraRoll);
-
-    // Render Grapple Rope
-    if (m_IsGrappling) {
-      SDL_SetRenderDrawColor(m_Renderer, 150, 150, 150, 255);
-      SDL_RenderDrawLine(m_Renderer, w / 2, h, w / 2, h / 2);
-    }
-
-    // Slow-mo Visual Cue (Ghosting)
-    if (m_TimeScale < 1.0f) {
-      SDL_SetRenderDrawBlendMode(m_Renderer, SDL_BLENDMODE_BLEND);
-      // Outer vignette for slow-mo
-      SDL_SetRenderDrawColor(m_Renderer, 0, 50, 150, 40);
-      SDL_Rect screenRect = {0, 0, w, h};
-      SDL_RenderFillRect(m_Renderer, &screenRect);
-
-      // Central focus
-      SDL_SetRenderDrawColor(m_Renderer, 255, 255, 255, 10);
-      SDL_Rect focus = {w / 4, h / 4, w / 2, h / 2};
-      SDL_RenderFillRect(m_Renderer, &focus);
-
-      SDL_SetRenderDrawBlendMode(m_Renderer, SDL_BLENDMODE_NONE);
-    }
     RenderUI();
   } else if (m_State == GameState::Paused) {
     m_Raycaster.Render(m_Renderer, *m_Camera, m_Map, m_Registry, m_CameraRoll);
     RenderUI(); // Optional: Hide UI behind pause?
     RenderPauseMenu();
   }
+
+  RenderStatsOverlay();
 }
@@ -1,4 +1,5 @@
 #include "../engine/Components.h"
+#include "../engine/FloorKernel.h"
 #include "JumpShootGame.h"
 #include <SDL2/SDL.h>
 
@@ -44,8 +45,11 @@ void JumpShootGame::RenderMainMenu() {
     std::string fsText = isFullscreen ? "FULLSCREEN: ON" : "FULLSCREEN: OFF";
     DrawButton(w / 2 - btnW / 2, startY, btnW, btnH, fsText,
                m_MenuSelection == 0);
-    DrawButton(w / 2 - btnW / 2, startY + gap, btnW, btnH, "BACK",
+    DrawButton(w / 2 - btnW / 2, startY + gap, btnW, btnH,
+               m_FilmEffects ? "FILM EFFECTS: ON" : "FILM EFFECTS: OFF",
                m_MenuSelection == 1);
+    DrawButton(w / 2 - btnW / 2, startY + gap * 2, btnW, btnH, "BACK",
+               m_MenuSelection == 2);
   }
 }
 
@@ -78,8 +82,11 @@ void JumpShootGame::RenderPauseMenu() {
     std::string fsText = isFullscreen ? "FULLSCREEN: ON" : "FULLSCREEN: OFF";
     DrawButton(w / 2 - btnW / 2, startY, btnW, btnH, fsText,
                m_MenuSelection == 0);
-    DrawButton(w / 2 - btnW / 2, startY + gap, btnW, btnH, "BACK",
+    DrawButton(w / 2 - btnW / 2, startY + gap, btnW, btnH,
+               m_FilmEffects ? "FILM EFFECTS: ON" : "FILM EFFECTS: OFF",
                m_MenuSelection == 1);
+    DrawButton(w / 2 - btnW / 2, startY + gap * 2, btnW, btnH, "BACK",
+               m_MenuSelection == 2);
   }
 }
 
@@ -207,4 +214,57 @@ void JumpShootGame::RenderUI() {
     m_TextRenderer->RenderTextCentered("Press R to Retry", w / 2,
                                        h / 2 + 90, {200, 200, 200, 255});
   }
-}
\ No newline at end of file
+}
+
+void JumpShootGame::RenderStatsOverlay() {
+  if (!m_ShowRenderStats)
+    return;
+  const RenderStats &stats = m_Raycaster.GetStats();
+  char line[128];
+  snprintf(line, sizeof(line),
+           "RENDERER: %s (F2), FLOOR: %s (F9), SPRITES: %s",
+           Raycaster::GetBackendName(m_Raycaster.GetBackend()),
+           m_Raycaster.IsTexturedFloor() ? "Textured" : GetFloorKernelName(),
+           GetSpriteKernelName());
+  m_TextRenderer->RenderTextSmall(line, 10, 10, {255, 255, 0, 255});
+  snprintf(line, sizeof(line), "3D VIEW: %.2f ms at %dx%d (%s scale, F7)",
+           stats.renderMs, stats.viewWidth, stats.viewHeight,
+           m_AutoResolution ? "auto" : "full");
+  m_TextRenderer->RenderTextSmall(line, 10, 30, {255, 255, 0, 255});
+  snprintf(line, sizeof(line),
+           "WALL CAST: %.2f ms on %d thread(s) (F4), RAYS: %s (F6)",
+           stats.wallCastMs, stats.castThreads,
+           Raycaster::GetRayTraversalName(m_Raycaster.GetRayTraversal()));
+  m_TextRenderer->RenderTextSmall(line, 10, 50, {255, 255, 0, 255});
+  if (m_Raycaster.IsAdaptiveColumns())
+    snprintf(line, sizeof(line),
+             "ADAPTIVE COLUMNS: %d rays cast, %d saved (F10)", stats.raysCast,
+             stats.raysSaved);
+  else
+    snprintf(line, sizeof(line), "ADAPTIVE COLUMNS: off (F10)");
+  m_TextRenderer->RenderTextSmall(line, 10, 70, {255, 255, 0, 255});
+  snprintf(line, sizeof(line),
+           "DDA STEPS: %lld (%.1f per ray), WALL MIPMAPS: %s (F8)",
+           stats.ddaSteps,
+           stats.raysCast ? (double)stats.ddaSteps / stats.raysCast : 0.0,
+           m_Raycaster.IsWallMipmaps() ? "on" : "off");
+  m_TextRenderer->RenderTextSmall(line, 10, 90, {255, 255, 0, 255});
+  snprintf(line, sizeof(line),
+           "SPRITES: %d drawn, %d outside view, %d behind walls",
+           stats.spritesDrawn, stats.spritesCulled, stats.spritesOccluded);
+  m_TextRenderer->RenderTextSmall(line, 10, 110, {255, 255, 0, 255});
+  if (m_Raycaster.GetBackend() == RenderBackend::SDLRenderer) {
+    snprintf(line, sizeof(line), "WALL DRAW CALLS: %d (%s, F5)",
+             stats.wallDrawCalls,
+             m_Raycaster.IsBatchedWalls() ? "batched" : "per column");
+    m_TextRenderer->RenderTextSmall(line, 10, 130, {255, 255, 0, 255});
+    snprintf(line, sizeof(line),
+             "SPRITE DRAW CALLS: %d (%d with one per visible column)",
+             stats.spriteDrawCalls, stats.spriteStripes);
+    m_TextRenderer->RenderTextSmall(line, 10, 150, {255, 255, 0, 255});
+  } else {
+    snprintf(line, sizeof(line), "WALL KERNEL: %s",
+             GetWallFeatureName(stats.wallFeatures));
+    m_TextRenderer->RenderTextSmall(line, 10, 130, {255, 255, 0, 255});
+  }
+}
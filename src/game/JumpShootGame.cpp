@@ -8,6 +8,8 @@ using namespace PixelsEngine;
 
 void JumpShootGame::OnUpdate(float deltaTime) {
 
+  HandleInputDebug();
+
   if (m_State == GameState::MainMenu) {
 
     m_MenuCamAngle += 0.2f * deltaTime;
@@ -203,11 +205,6 @@ void JumpShootGame::PlaySpatialSfx(Mix_Chunk *chunk, float x, float y,
   if (!chunk || !m_Camera)
     return;
 
-  int channel = Mix_PlayChannel(-1, chunk, 0);
-
-  if (channel == -1)
-    return;
-
   float dx = x - m_Camera->x;
 
   float dy = y - m_Camera->y;
@@ -218,6 +215,16 @@ void JumpShootGame::PlaySpatialSfx(Mix_Chunk *chunk, float x, float y,
 
   int volume = (int)(MIX_MAX_VOLUME * (1.0f - std::min(1.0f, dist / 20.0f)));
 
+  // Out of earshot: no channel needed
+
+  if (volume <= 0)
+    return;
+
+  int channel = Mix_PlayChannel(-1, chunk, 0);
+
+  if (channel == -1)
+    return;
+
   Mix_Volume(channel, volume);
 
   // Panning
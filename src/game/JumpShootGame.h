@@ -3,6 +3,7 @@
 #include "../engine/ECS.h"
 #include "../engine/Map.h"
 #include "../engine/Raycaster.h"
+#include "../engine/ResolutionController.h"
 #include "../engine/TextRenderer.h"
 #include <memory>
 
@@ -30,10 +31,12 @@ private:
   void RenderGameplay();
   void RenderUI();
   void RenderPauseMenu();
+  void RenderStatsOverlay();
 
   void HandleInputGameplay(float dt);
   void HandleInputMenu();
   void HandleInputPause();
+  void HandleInputDebug();
 
   void UpdatePhysics(float dt);
   void UpdateProjectiles(float dt);
@@ -43,6 +46,7 @@ private:
                   bool selected);
 
   PixelsEngine::Raycaster m_Raycaster;
+  PixelsEngine::ResolutionController m_ResolutionController;
   PixelsEngine::Map m_Map;
   std::unique_ptr<PixelsEngine::TextRenderer> m_TextRenderer;
 
@@ -62,6 +66,9 @@ private:
   GameState m_State = GameState::MainMenu;
   int m_MenuSelection = 0; // 0: Play/Resume, 1: Options, 2: Quit/MainMenu
   bool m_InOptions = false;
+  bool m_ShowRenderStats = false;
+  bool m_AutoResolution = false; // F7; full resolution until turned on
+  bool m_FilmEffects = false;    // Options: scanlines and grain on the menu
 
   // Gameplay Stats & Juice
   float m_HitmarkerTimer = 0.0f;